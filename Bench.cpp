@@ -0,0 +1,142 @@
+#include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include "CountingAllocator.hpp"
+#include "SimdMath.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+double sink = 0.0;
+bool firstResult = true;
+
+struct Family {
+    const char* name;
+    std::vector<size_t> sizes;
+    std::function<std::string(size_t)> generate;
+};
+
+std::vector<Family> families() {
+    return {
+        {"sum", {10, 100, 1000, 10000}, [](size_t n) {
+            std::string s = "x";
+            for (size_t i = 1; i < n; i++) s += " + " + std::to_string(i) + " * " + (i % 2 ? "y" : "x");
+            return s;
+        }},
+        {"product", {10, 100, 400}, [](size_t n) {
+            std::string s = "x";
+            for (size_t i = 1; i < n; i++) s = "(" + std::string(i % 2 ? "y" : "x") + " + 0.5) * (" + s + ")";
+            return s;
+        }},
+        {"tower", {10, 100, 400}, [](size_t n) {
+            std::string s = "x";
+            for (size_t i = 0; i < n; i++) s = std::string(i % 2 ? "exp" : "sin") + "(" + s + ")";
+            return s;
+        }},
+        {"polynomial", {4, 16, 48}, [](size_t n) {
+            std::string s = "x ^ " + std::to_string(n);
+            for (size_t i = n; i-- > 0;) s += " + " + std::to_string(i + 1) + " * x ^ " + std::to_string(i) + (i % 4 ? "" : " * y");
+            return s;
+        }},
+        {"power", {2, 4, 8}, [](size_t n) {
+            std::string s = "x";
+            for (size_t i = 0; i < n; i++) s += std::string(" ^ ") + (i % 2 ? "x" : "y");
+            return s;
+        }},
+    };
+}
+
+template <typename T>
+const char* typeName() {
+    return std::is_same_v<T, double> ? "double" : "complex";
+}
+
+template <typename T>
+T pointValue(double re) {
+    if constexpr (std::is_same_v<T, double>) return re;
+    else return T(re, 0.125);
+}
+
+template <typename T>
+double magnitude(T value) {
+    return std::abs(value);
+}
+
+template <typename T, typename F>
+void measure(const char* family, size_t size, size_t nodes, const char* operation, size_t points, F&& body) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration window = std::chrono::milliseconds(50);
+    typename ExpressionArena<T>::Scope scope(std::make_shared<ExpressionArena<T>>());
+    uint64_t allocationsBefore = CountingAllocator::allocations();
+    uint64_t bytesBefore = CountingAllocator::bytes();
+    size_t iterations = 1;
+    Clock::time_point start = Clock::now();
+    body();
+    Clock::duration elapsed = Clock::now() - start;
+    if (elapsed < window) {
+        typename ExpressionArena<T>::Scope measured(std::make_shared<ExpressionArena<T>>());
+        allocationsBefore = CountingAllocator::allocations();
+        bytesBefore = CountingAllocator::bytes();
+        iterations = 0;
+        start = Clock::now();
+        do {
+            body();
+            iterations++;
+            elapsed = Clock::now() - start;
+        } while (elapsed < window && iterations < 1000000);
+    }
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    std::printf("%s\n    {\"type\": \"%s\", \"family\": \"%s\", \"size\": %zu, \"nodes\": %zu, \"operation\": \"%s\", "
+                "\"points\": %zu, \"iterations\": %zu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f}",
+                firstResult ? "" : ",", typeName<T>(), family, size, nodes, operation, points, iterations, ns,
+                static_cast<double>(CountingAllocator::allocations() - allocationsBefore) / iterations,
+                static_cast<double>(CountingAllocator::bytes() - bytesBefore) / iterations);
+    firstResult = false;
+}
+
+template <typename T>
+void runFamily(const Family& family) {
+    const size_t batchPoints = 4096;
+    for (size_t size : family.sizes) {
+        std::string text = family.generate(size);
+        Expression<T> expr = Expression<T>::fromString(text);
+        size_t nodes = expr.size();
+        std::map<std::string, T> values{{"x", pointValue<T>(0.75)}, {"y", pointValue<T>(1.25)}};
+        CompiledExpression<T> compiled(expr);
+        std::vector<T> point;
+        for (const std::string& var : compiled.variables()) point.push_back(values.at(var));
+        std::vector<std::vector<T>> columns(point.size());
+        std::vector<const T*> columnPointers;
+        for (size_t v = 0; v < point.size(); v++) {
+            for (size_t i = 0; i < batchPoints; i++) columns[v].push_back(point[v] + pointValue<T>(i * 1e-4));
+            columnPointers.push_back(columns[v].data());
+        }
+        std::vector<T> out(batchPoints);
+
+        measure<T>(family.name, size, nodes, "fromString", 1, [&] { sink += Expression<T>::fromString(text).size(); });
+        measure<T>(family.name, size, nodes, "differentiate", 1, [&] { sink += expr.differentiate("x").size(); });
+        measure<T>(family.name, size, nodes, "simplify", 1, [&] { sink += expr.simplified().size(); });
+        measure<T>(family.name, size, nodes, "toString", 1, [&] { sink += expr.toString().size(); });
+        measure<T>(family.name, size, nodes, "evaluate", 1, [&] { sink += magnitude(expr.evaluate(values)); });
+        measure<T>(family.name, size, nodes, "compile", 1, [&] { sink += CompiledExpression<T>(expr).size(); });
+        measure<T>(family.name, size, nodes, "compiledEvaluate", 1, [&] { sink += magnitude(compiled.evaluate(point.data())); });
+        measure<T>(family.name, size, nodes, "evaluateBatch", batchPoints, [&] {
+            compiled.evaluateBatch(columnPointers.data(), out.data(), batchPoints);
+            sink += magnitude(out[batchPoints / 2]);
+        });
+    }
+}
+
+}
+
+int main() {
+    CountingAllocator::enable();
+    std::printf("{\n  \"benchmark\": \"expressions\",\n  \"simd_width\": %zu,\n  \"results\": [", simd::width);
+    for (const Family& family : families()) runFamily<double>(family);
+    for (const Family& family : families()) runFamily<std::complex<double>>(family);
+    std::printf("\n  ],\n  \"checksum\": %.6g\n}\n", sink);
+    return 0;
+}
\ No newline at end of file
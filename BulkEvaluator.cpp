@@ -0,0 +1,193 @@
+#include "BulkEvaluator.hpp"
+#include "ThreadPool.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// Reads comma-separated rows one line at a time; the first line names the
+// columns. Only the current line is held in memory.
+class CsvReader {
+public:
+    explicit CsvReader(std::istream& in) : in(in), lineNumber(0) {
+        std::string line;
+        if (!std::getline(in, line)) throw std::runtime_error("Missing CSV header line.");
+        lineNumber++;
+        size_t begin = 0;
+        while (begin <= line.size()) {
+            size_t end = line.find(',', begin);
+            if (end == std::string::npos) end = line.size();
+            size_t first = line.find_first_not_of(" \t\r", begin);
+            size_t last = line.find_last_not_of(" \t\r", end - 1);
+            names.push_back(first < end && last != std::string::npos && last >= first ? line.substr(first, last - first + 1) : "");
+            begin = end + 1;
+        }
+    }
+
+    const std::vector<std::string>& header() const {
+        return names;
+    }
+
+    size_t index(const std::string& name) const {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) return i;
+        }
+        throw std::runtime_error("CSV input has no column '" + name + "'.");
+    }
+
+    bool next(std::vector<double>& fields) {
+        while (std::getline(in, line)) {
+            lineNumber++;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            fields.resize(names.size());
+            const char* p = line.c_str();
+            for (size_t i = 0; i < names.size(); i++) {
+                char* end = nullptr;
+                fields[i] = std::strtod(p, &end);
+                if (end == p) throw std::runtime_error("Invalid number on CSV line " + std::to_string(lineNumber) + ".");
+                while (*end == ' ' || *end == '\t' || *end == '\r') end++;
+                if (i + 1 < names.size() ? *end != ',' : *end != '\0') {
+                    throw std::runtime_error("Expected " + std::to_string(names.size()) + " fields on CSV line " + std::to_string(lineNumber) + ".");
+                }
+                p = end + 1;
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    std::istream& in;
+    std::string line;
+    std::vector<std::string> names;
+    size_t lineNumber;
+};
+
+}
+
+BulkEvaluator::BulkEvaluator(const Expression<double>& expr, const std::vector<std::string>& derivatives, bool statusColumn)
+    : variableNames(expr.variables()),
+      outputNames{"value"},
+      statusColumn(statusColumn) {
+    compiled.emplace_back(expr, variableNames);
+    for (const std::string& var : derivatives) {
+        outputNames.push_back("d/d" + var);
+        compiled.emplace_back(expr.differentiate(var), variableNames);
+    }
+    if (statusColumn) outputNames.push_back("status");
+}
+
+DomainReport BulkEvaluator::evaluateBlocks(const double* const* columns, double* const* out, size_t begin, size_t end) const {
+    DomainReport report;
+    std::vector<const double*> shifted(variableNames.size());
+    std::vector<unsigned char> flags(blockRows), partial(blockRows);
+    for (size_t start = begin; start < end; start += blockRows) {
+        size_t n = std::min(blockRows, end - start);
+        for (size_t v = 0; v < shifted.size(); v++) shifted[v] = columns[v] + start;
+        compiled[0].evaluateBatch(shifted.data(), out[0] + start, n, flags.data());
+        for (size_t k = 1; k < compiled.size(); k++) {
+            compiled[k].evaluateBatch(shifted.data(), out[k] + start, n, partial.data());
+            for (size_t i = 0; i < n; i++) flags[i] |= partial[i];
+        }
+        report.record(flags.data(), n);
+        if (statusColumn) std::copy(flags.begin(), flags.begin() + n, out[compiled.size()] + start);
+    }
+    return report;
+}
+
+DomainReport BulkEvaluator::evaluate(const double* const* columns, double* const* out, size_t rows) const {
+    return evaluateBlocks(columns, out, 0, rows);
+}
+
+DomainReport BulkEvaluator::evaluate(const double* const* columns, double* const* out, size_t rows, ThreadPool& pool) const {
+    DomainReport report;
+    std::mutex merging;
+    pool.parallelFor(rows, blockRows, [this, columns, out, &report, &merging](size_t begin, size_t end) {
+        DomainReport part = evaluateBlocks(columns, out, begin, end);
+        std::lock_guard<std::mutex> lock(merging);
+        report.merge(part);
+    });
+    return report;
+}
+
+DomainReport BulkEvaluator::evaluate(const ColumnFile& input, const std::string& outputPath, ThreadPool* pool) const {
+    std::vector<const double*> columns;
+    for (const std::string& var : variableNames) columns.push_back(input.column(input.index(var)));
+    ColumnFile output(outputPath, outputNames, input.rows());
+    std::vector<double*> out;
+    for (size_t k = 0; k < outputNames.size(); k++) out.push_back(output.writableColumn(k));
+    if (pool) return evaluate(columns.data(), out.data(), input.rows(), *pool);
+    return evaluate(columns.data(), out.data(), input.rows());
+}
+
+DomainReport BulkEvaluator::evaluateCsv(std::istream& in, std::ostream& out) const {
+    CsvReader reader(in);
+    std::vector<size_t> sources;
+    for (const std::string& var : variableNames) sources.push_back(reader.index(var));
+
+    std::vector<double> inputs(variableNames.size() * blockRows);
+    std::vector<double> results(outputNames.size() * blockRows);
+    std::vector<const double*> columns;
+    std::vector<double*> destinations;
+    for (size_t v = 0; v < variableNames.size(); v++) columns.push_back(inputs.data() + v * blockRows);
+    for (size_t k = 0; k < outputNames.size(); k++) destinations.push_back(results.data() + k * blockRows);
+
+    for (size_t k = 0; k < outputNames.size(); k++) out << (k ? "," : "") << outputNames[k];
+    out << "\n";
+    std::string text;
+    DomainReport report;
+    auto flush = [&](size_t n) {
+        report.merge(evaluate(columns.data(), destinations.data(), n));
+        char number[32];
+        text.clear();
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = 0; k < outputNames.size(); k++) {
+                if (k) text += ',';
+                text.append(number, std::snprintf(number, sizeof(number), "%.17g", destinations[k][i]));
+            }
+            text += '\n';
+        }
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    };
+
+    size_t filled = 0;
+    for (std::vector<double> fields; reader.next(fields);) {
+        for (size_t v = 0; v < sources.size(); v++) inputs[v * blockRows + filled] = fields[sources[v]];
+        if (++filled == blockRows) {
+            flush(filled);
+            filled = 0;
+        }
+    }
+    if (filled) flush(filled);
+    return report;
+}
+
+size_t BulkEvaluator::pack(const std::string& csvPath, const std::string& outputPath) {
+    std::ifstream counting(csvPath);
+    if (!counting) throw std::runtime_error("Cannot open " + csvPath);
+    CsvReader counter(counting);
+    size_t rows = 0;
+    for (std::vector<double> fields; counter.next(fields);) rows++;
+
+    std::ifstream in(csvPath);
+    CsvReader reader(in);
+    ColumnFile output(outputPath, reader.header(), rows);
+    std::vector<double*> columns;
+    for (size_t c = 0; c < reader.header().size(); c++) columns.push_back(output.writableColumn(c));
+    size_t row = 0;
+    for (std::vector<double> fields; row < rows && reader.next(fields); row++) {
+        for (size_t c = 0; c < columns.size(); c++) columns[c][row] = fields[c];
+    }
+    return row;
+}
+
+const std::vector<std::string>& BulkEvaluator::variables() const {
+    return variableNames;
+}
+
+const std::vector<std::string>& BulkEvaluator::outputs() const {
+    return outputNames;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef BULK_EVALUATOR_HPP
+#define BULK_EVALUATOR_HPP
+
+#include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include "ColumnFile.hpp"
+#include "DomainReport.hpp"
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+
+class ThreadPool;
+
+// Evaluates one expression and a fixed set of its derivatives over many rows.
+// Every output is compiled once; rows are walked in blocks of blockRows so a
+// block of inputs stays in cache while all outputs are computed from it, and
+// each output is written straight into its destination column. Domain errors
+// are flagged per row and counted in the returned DomainReport; with
+// statusColumn the OR of each row's DomainFlag bits is a last "status" output.
+class BulkEvaluator {
+public:
+    static constexpr size_t blockRows = 4096;
+
+    explicit BulkEvaluator(const Expression<double>& expr, const std::vector<std::string>& derivatives = {}, bool statusColumn = false);
+
+    DomainReport evaluate(const double* const* columns, double* const* out, size_t rows) const;
+    DomainReport evaluate(const double* const* columns, double* const* out, size_t rows, ThreadPool& pool) const;
+    DomainReport evaluate(const ColumnFile& input, const std::string& outputPath, ThreadPool* pool = nullptr) const;
+    DomainReport evaluateCsv(std::istream& in, std::ostream& out) const;
+
+    const std::vector<std::string>& variables() const;
+    const std::vector<std::string>& outputs() const;
+
+    static size_t pack(const std::string& csvPath, const std::string& outputPath);
+
+private:
+    DomainReport evaluateBlocks(const double* const* columns, double* const* out, size_t begin, size_t end) const;
+
+    std::vector<std::string> variableNames;
+    std::vector<std::string> outputNames;
+    std::vector<CompiledExpression<double>> compiled;
+    bool statusColumn;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "ColumnFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char magic[8] = {'E', 'X', 'P', 'R', 'C', 'O', 'L', '1'};
+constexpr size_t fixedHeader = sizeof(magic) + 3 * sizeof(uint64_t);
+
+size_t roundUp(size_t bytes) {
+    return (bytes + ColumnFile::alignment - 1) / ColumnFile::alignment * ColumnFile::alignment;
+}
+
+std::runtime_error failure(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+}
+
+ColumnFile::ColumnFile(const std::string& path) : rowCount(0), base(nullptr), length(0), writable(false) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw failure("Cannot open", path);
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::runtime_error error = failure("Cannot stat", path);
+        ::close(fd);
+        throw error;
+    }
+    if (static_cast<size_t>(info.st_size) < fixedHeader) {
+        ::close(fd);
+        throw std::runtime_error("Not a column file: " + path);
+    }
+    map(fd, static_cast<size_t>(info.st_size), false);
+
+    try {
+        uint64_t header[3];
+        std::memcpy(header, base + sizeof(magic), sizeof(header));
+        if (std::memcmp(base, magic, sizeof(magic)) != 0) throw std::runtime_error("Not a column file: " + path);
+        if (header[2] % alignment || header[2] > length || header[0] > (length - header[2]) / sizeof(double)) {
+            throw std::runtime_error("Truncated column file: " + path);
+        }
+        rowCount = header[0];
+        size_t stride = roundUp(rowCount * sizeof(double));
+        if (stride && header[1] > (length - header[2]) / stride) throw std::runtime_error("Truncated column file: " + path);
+        const char* name = reinterpret_cast<const char*>(base + fixedHeader);
+        const char* end = reinterpret_cast<const char*>(base + header[2]);
+        for (uint64_t i = 0; i < header[1]; i++) {
+            const char* stop = static_cast<const char*>(std::memchr(name, '\0', end - name));
+            if (!stop) throw std::runtime_error("Corrupt column names in " + path);
+            columnNames.emplace_back(name, stop);
+            offsets.push_back(header[2] + i * stride);
+            name = stop + 1;
+        }
+    } catch (...) {
+        munmap(base, length);
+        base = nullptr;
+        throw;
+    }
+}
+
+ColumnFile::ColumnFile(const std::string& path, const std::vector<std::string>& names, size_t rows)
+    : columnNames(names), rowCount(rows), base(nullptr), length(0), writable(true) {
+    size_t namesBytes = 0;
+    for (const std::string& name : names) namesBytes += name.size() + 1;
+    size_t data = roundUp(fixedHeader + namesBytes);
+    size_t stride = roundUp(rows * sizeof(double));
+    for (size_t i = 0; i < names.size(); i++) offsets.push_back(data + i * stride);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw failure("Cannot create", path);
+    size_t total = std::max(data + names.size() * stride, alignment);
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        std::runtime_error error = failure("Cannot size", path);
+        ::close(fd);
+        throw error;
+    }
+    map(fd, total, true);
+
+    uint64_t header[3] = {rows, names.size(), data};
+    std::memcpy(base, magic, sizeof(magic));
+    std::memcpy(base + sizeof(magic), header, sizeof(header));
+    unsigned char* cursor = base + fixedHeader;
+    for (const std::string& name : names) {
+        std::memcpy(cursor, name.c_str(), name.size() + 1);
+        cursor += name.size() + 1;
+    }
+}
+
+void ColumnFile::map(int fd, size_t bytes, bool write) {
+    void* address = mmap(nullptr, bytes, write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        std::runtime_error error(std::string("Cannot map column file: ") + std::strerror(errno));
+        ::close(fd);
+        throw error;
+    }
+    ::close(fd);
+    base = static_cast<unsigned char*>(address);
+    length = bytes;
+    madvise(base, length, MADV_SEQUENTIAL);
+}
+
+ColumnFile::~ColumnFile() {
+    if (base) munmap(base, length);
+}
+
+ColumnFile::ColumnFile(ColumnFile&& other) noexcept
+    : columnNames(std::move(other.columnNames)),
+      offsets(std::move(other.offsets)),
+      rowCount(other.rowCount),
+      base(other.base),
+      length(other.length),
+      writable(other.writable) {
+    other.base = nullptr;
+    other.length = 0;
+}
+
+const std::vector<std::string>& ColumnFile::names() const {
+    return columnNames;
+}
+
+size_t ColumnFile::rows() const {
+    return rowCount;
+}
+
+size_t ColumnFile::index(const std::string& name) const {
+    for (size_t i = 0; i < columnNames.size(); i++) {
+        if (columnNames[i] == name) return i;
+    }
+    throw std::out_of_range("Unknown column: '" + name + "'");
+}
+
+const double* ColumnFile::column(size_t i) const {
+    return reinterpret_cast<const double*>(base + offsets.at(i));
+}
+
+double* ColumnFile::writableColumn(size_t i) {
+    if (!writable) throw std::logic_error("Column file is open read-only.");
+    return reinterpret_cast<double*>(base + offsets.at(i));
+}
+
+void ColumnFile::sync() {
+    if (writable && msync(base, length, MS_SYNC) != 0) throw std::runtime_error(std::string("Cannot sync column file: ") + std::strerror(errno));
+}
+
+bool ColumnFile::recognize(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char head[sizeof(magic)] = {};
+    return in.read(head, sizeof(head)) && std::memcmp(head, magic, sizeof(magic)) == 0;
+}
\ No newline at end of file
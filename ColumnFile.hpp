@@ -0,0 +1,46 @@
+#ifndef COLUMN_FILE_HPP
+#define COLUMN_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Memory-mapped columnar file of doubles. Layout, in native byte order:
+//   "EXPRCOL1", uint64 rows, uint64 columns, uint64 data offset,
+//   the column names as NUL-terminated strings,
+//   then one array of rows doubles per column, each starting on a 64-byte
+//   boundary and padded to the next one.
+// Opening maps the file read-only; creating sizes it, writes the header and
+// maps it read-write, so results land in the file without a copy.
+class ColumnFile {
+public:
+    static constexpr size_t alignment = 64;
+
+    explicit ColumnFile(const std::string& path);
+    ColumnFile(const std::string& path, const std::vector<std::string>& names, size_t rows);
+    ~ColumnFile();
+    ColumnFile(ColumnFile&& other) noexcept;
+    ColumnFile(const ColumnFile&) = delete;
+    ColumnFile& operator=(const ColumnFile&) = delete;
+
+    const std::vector<std::string>& names() const;
+    size_t rows() const;
+    size_t index(const std::string& name) const;
+    const double* column(size_t i) const;
+    double* writableColumn(size_t i);
+    void sync();
+
+    static bool recognize(const std::string& path);
+
+private:
+    void map(int fd, size_t length, bool writable);
+
+    std::vector<std::string> columnNames;
+    std::vector<uint64_t> offsets;
+    size_t rowCount;
+    unsigned char* base;
+    size_t length;
+    bool writable;
+};
+
+#endif
\ No newline at end of file
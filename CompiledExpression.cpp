@@ -0,0 +1,747 @@
+#include "CompiledExpression.hpp"
+#include "SimdMath.hpp"
+#include "ExpressionMath.hpp"
+#include "SymbolTable.hpp"
+#include "ThreadPool.hpp"
+#include "ExpressionStats.hpp"
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t batchBlock = 256;
+
+template <typename Op>
+void batchBinary(double* a, const double* b, size_t lanes, Op op) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::store(a + i, op(simd::load(a + i), simd::load(b + i)));
+    }
+}
+
+template <typename Op>
+void batchUnary(double* a, size_t lanes, Op op) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::store(a + i, op(simd::load(a + i)));
+    }
+}
+
+void batchPowInt(double* a, size_t lanes, int exponent) {
+    unsigned int n = static_cast<unsigned int>(exponent < 0 ? -exponent : exponent);
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double base = simd::load(a + i);
+        simd::Double result = simd::splat(1.0);
+        for (unsigned int k = n; k; k >>= 1) {
+            if (k & 1) result = result * base;
+            base = base * base;
+        }
+        simd::store(a + i, exponent < 0 ? simd::splat(1.0) / result : result);
+    }
+}
+
+void batchTrig(double* a, size_t lanes, bool cosine) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double v = simd::load(a + i);
+        if (simd::needsLibmTrig(v)) {
+            for (size_t j = i; j < i + simd::width; j++) a[j] = cosine ? std::cos(a[j]) : std::sin(a[j]);
+        } else {
+            simd::store(a + i, cosine ? simd::cos(v) : simd::sin(v));
+        }
+    }
+}
+
+template <typename Test>
+void flagLanes(const double* a, size_t n, unsigned char* flags, unsigned char flag, Test test) {
+    for (size_t i = 0; i < n; i++) flags[i] |= test(a[i]) ? flag : 0;
+}
+
+template <typename T>
+T polynomialAt(const Polynomial<T>& p, const std::vector<unsigned int>& slots, const T* values) {
+    T x[Polynomial<T>::maxVariables];
+    for (size_t v = 0; v < slots.size(); v++) x[v] = values[slots[v]];
+    return p.evaluate(x);
+}
+
+// Per-thread work space for the overloads that take no scratch, so one
+// CompiledExpression can be shared between threads.
+enum Workspace { STACK, INPUTS, TAPE, ADJOINTS, WORKSPACES };
+
+template <typename T>
+T* workspace(Workspace which, size_t size) {
+    static thread_local std::vector<T> buffers[WORKSPACES];
+    std::vector<T>& buffer = buffers[which];
+    if (buffer.size() < size) buffer.resize(size);
+    return buffer.data();
+}
+
+typedef std::complex<double> Complex;
+
+simd::Double absolute(simd::Double x) {
+    return x < simd::splat(0.0) ? -x : x;
+}
+
+template <typename Op>
+void splitLanes(double* ar, double* ai, const double* br, const double* bi, size_t begin, size_t end, Op op) {
+    for (size_t j = begin; j < end; j++) {
+        Complex r = op(Complex(ar[j], ai[j]), Complex(br[j], bi[j]));
+        ar[j] = r.real();
+        ai[j] = r.imag();
+    }
+}
+
+void splitMultiply(double* ar, double* ai, const double* br, const double* bi, size_t lanes) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double a = simd::load(ar + i), b = simd::load(ai + i);
+        simd::Double c = simd::load(br + i), d = simd::load(bi + i);
+        simd::store(ar + i, a * c - b * d);
+        simd::store(ai + i, a * d + b * c);
+    }
+}
+
+// With status, a zero divisor flags its lane and leaves NaN there instead of throwing.
+void splitDivide(double* ar, double* ai, const double* br, const double* bi, size_t n, size_t lanes, unsigned char* status) {
+    for (size_t j = 0; j < n; j++) {
+        if (br[j] != 0.0 || bi[j] != 0.0) continue;
+        if (!status) throw std::runtime_error("Division by zero for complex.");
+        status[j] |= DIVISION_BY_ZERO;
+    }
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double a = simd::load(ar + i), b = simd::load(ai + i);
+        simd::Double c = simd::load(br + i), d = simd::load(bi + i);
+        simd::Mask wide = absolute(c) >= absolute(d);
+        simd::Double r = wide ? d / c : c / d;
+        simd::Double den = wide ? c + d * r : c * r + d;
+        simd::store(ar + i, (wide ? a + b * r : a * r + b) / den);
+        simd::store(ai + i, (wide ? b - a * r : b * r - a) / den);
+    }
+}
+
+void splitExp(double* ar, double* ai, size_t lanes) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double a = simd::load(ar + i), b = simd::load(ai + i);
+        if (simd::anyLane((absolute(a) > simd::splat(700.0)) | (a != a)) || simd::needsLibmTrig(b)) {
+            splitLanes(ar, ai, ar, ai, i, i + simd::width, [](Complex x, Complex) { return std::exp(x); });
+            continue;
+        }
+        simd::Double e = simd::exp(a);
+        simd::store(ar + i, e * simd::cos(b));
+        simd::store(ai + i, e * simd::sin(b));
+    }
+}
+
+void splitTrig(double* ar, double* ai, size_t lanes, bool cosine) {
+    for (size_t i = 0; i < lanes; i += simd::width) {
+        simd::Double a = simd::load(ar + i), b = simd::load(ai + i);
+        if (simd::needsLibmTrig(a) || simd::anyLane((absolute(b) > simd::splat(700.0)) | (b != b))) {
+            splitLanes(ar, ai, ar, ai, i, i + simd::width, [cosine](Complex x, Complex) { return cosine ? std::cos(x) : std::sin(x); });
+            continue;
+        }
+        simd::Double up = simd::exp(b), down = simd::exp(-b);
+        simd::Double z = b * b;
+        simd::Double series = simd::splat(1.0 / 6227020800.0);
+        series = series * z + simd::splat(1.0 / 39916800.0);
+        series = series * z + simd::splat(1.0 / 362880.0);
+        series = series * z + simd::splat(1.0 / 5040.0);
+        series = series * z + simd::splat(1.0 / 120.0);
+        series = series * z + simd::splat(1.0 / 6.0);
+        simd::Double sinh = absolute(b) < simd::splat(0.5) ? b + b * z * series : simd::splat(0.5) * (up - down);
+        simd::Double cosh = simd::splat(0.5) * (up + down);
+        simd::Double sa = simd::sin(a), ca = simd::cos(a);
+        simd::store(ar + i, (cosine ? ca : sa) * cosh);
+        simd::store(ai + i, cosine ? -(sa * sinh) : ca * sinh);
+    }
+}
+
+}
+
+template <typename T>
+CompiledExpression<T>::CompiledExpression(const Expression<T>& expr) : maxDepth(0), registers(0) {
+    build(expr, true);
+}
+
+template <typename T>
+CompiledExpression<T>::CompiledExpression(const Expression<T>& expr, const std::vector<std::string>& order)
+    : variableNames(order),
+      maxDepth(0),
+      registers(0) {
+    build(expr, false);
+}
+
+template <typename T>
+void CompiledExpression<T>::build(const Expression<T>& expr, bool extendVariables) {
+    ExpressionStats::Timer timer(ExpressionStats::COMPILE);
+    compile(*expr.arena, expr.id, extendVariables);
+
+    // A LOAD stands for the instruction whose value was stored, so the
+    // gradient tape links every parent straight to the shared node.
+    std::vector<unsigned int> pending;
+    std::vector<unsigned int> sources(registers);
+    operands.resize(code.size());
+    for (unsigned int i = 0; i < code.size(); i++) {
+        switch (code[i].opcode) {
+        case LOAD:
+            operands[i] = {0, 0};
+            pending.push_back(sources[code[i].operand]);
+            continue;
+        case STORE:
+            operands[i] = {0, 0};
+            sources[code[i].operand] = pending.back();
+            continue;
+        case CONST: case VAR: case POLY:
+            operands[i] = {0, 0};
+            break;
+        case SIN: case COS: case LN: case EXP:
+            operands[i] = {pending.back(), 0};
+            pending.pop_back();
+            break;
+        default:
+            operands[i] = {pending[pending.size() - 2], pending.back()};
+            pending.resize(pending.size() - 2);
+            break;
+        }
+        pending.push_back(i);
+    }
+}
+
+template <typename T>
+void CompiledExpression<T>::compile(const ExpressionArena<T>& arena, unsigned int root, bool extendVariables) {
+    typedef ExpressionArena<T> Arena;
+    struct Frame {
+        unsigned int id;
+        size_t depth;
+        bool expanded;
+    };
+    std::unordered_map<unsigned int, unsigned int> slots;
+    for (size_t i = 0; i < variableNames.size(); i++) {
+        slots[SymbolTable::intern(variableNames[i])] = static_cast<unsigned int>(i);
+    }
+    auto slot = [&](unsigned int symbol) {
+        auto it = slots.find(symbol);
+        if (it == slots.end()) {
+            if (!extendVariables) throw std::invalid_argument("Variable '" + SymbolTable::name(symbol) + "' is not bound.");
+            it = slots.emplace(symbol, static_cast<unsigned int>(variableNames.size())).first;
+            variableNames.push_back(SymbolTable::name(symbol));
+        }
+        return it->second;
+    };
+    std::unordered_map<unsigned int, Polynomial<T>> found = Polynomial<T>::find(arena, root);
+
+    // Count the parents each node has in the code to be emitted. An inner node
+    // with several keeps its value in a register from its first use until its
+    // last LOAD, after which the register is handed out again.
+    std::unordered_map<unsigned int, unsigned int> uses{{root, 1}};
+    std::vector<unsigned int> walk{root};
+    while (!walk.empty()) {
+        const typename Arena::Node& m = arena.node(walk.back());
+        bool inner = !found.count(walk.back()) && (m.type == Arena::OPERATION || m.type == Arena::FUNCTION);
+        walk.pop_back();
+        if (!inner) continue;
+        if (uses[m.left]++ == 0) walk.push_back(m.left);
+        if (m.type == Arena::OPERATION && uses[m.right]++ == 0) walk.push_back(m.right);
+    }
+    std::unordered_map<unsigned int, unsigned int> stored;
+    std::vector<unsigned int> freeRegisters;
+    auto share = [&](unsigned int id) {
+        if (uses.at(id) < 2) return;
+        unsigned int reg = static_cast<unsigned int>(registers);
+        if (freeRegisters.empty()) {
+            registers++;
+        } else {
+            reg = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+        uses.at(id)--;
+        stored.emplace(id, reg);
+        code.push_back({STORE, reg});
+    };
+
+    std::vector<Frame> pending{{root, 1, false}};
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        const typename Arena::Node& n = arena.node(frame.id);
+        maxDepth = std::max(maxDepth, frame.depth);
+        auto saved = stored.find(frame.id);
+        if (saved != stored.end()) {
+            pending.pop_back();
+            code.push_back({LOAD, saved->second});
+            if (--uses.at(frame.id) == 0) freeRegisters.push_back(saved->second);
+            continue;
+        }
+        auto polynomial = frame.expanded ? found.end() : found.find(frame.id);
+        if (polynomial != found.end()) {
+            pending.pop_back();
+            if (extendVariables) {
+                // Hand out slots in the order the tree names the variables, as without the fast path.
+                std::vector<unsigned int> walk{frame.id};
+                std::unordered_map<unsigned int, char> walked;
+                while (!walk.empty()) {
+                    unsigned int id = walk.back();
+                    walk.pop_back();
+                    if (!walked.emplace(id, 1).second) continue;
+                    const typename Arena::Node& m = arena.node(id);
+                    if (m.type == Arena::VARIABLE) slot(m.symbol);
+                    if (m.type == Arena::OPERATION) {
+                        walk.push_back(m.right);
+                        walk.push_back(m.left);
+                    }
+                }
+            }
+            PolynomialCall call{std::move(polynomial->second), {}, {}};
+            for (const std::string& var : call.polynomial.variables()) {
+                call.slots.push_back(slot(SymbolTable::intern(var)));
+                call.partials.push_back(call.polynomial.derivative(var));
+            }
+            polynomials.push_back(std::move(call));
+            code.push_back({POLY, static_cast<unsigned int>(polynomials.size() - 1)});
+            share(frame.id);
+            continue;
+        }
+        if (n.type == Arena::CONSTANT) {
+            pending.pop_back();
+            constants.push_back(n.value);
+            code.push_back({CONST, static_cast<unsigned int>(constants.size() - 1)});
+            continue;
+        }
+        if (n.type == Arena::VARIABLE) {
+            pending.pop_back();
+            code.push_back({VAR, slot(n.symbol)});
+            continue;
+        }
+        if (!frame.expanded) {
+            pending.back().expanded = true;
+            if (n.type == Arena::OPERATION) pending.push_back({n.right, frame.depth + 1, false});
+            pending.push_back({n.left, frame.depth, false});
+            continue;
+        }
+        pending.pop_back();
+        if (n.type == Arena::FUNCTION) {
+            switch (n.function) {
+            case Arena::SIN: code.push_back({SIN, 0}); break;
+            case Arena::COS: code.push_back({COS, 0}); break;
+            case Arena::LN: code.push_back({LN, 0}); break;
+            case Arena::EXP: code.push_back({EXP, 0}); break;
+            default: throw std::runtime_error("Unknown function");
+            }
+            share(frame.id);
+            continue;
+        }
+        switch (n.operation) {
+        case '+': code.push_back({ADD, 0}); break;
+        case '-': code.push_back({SUB, 0}); break;
+        case '*': code.push_back({MUL, 0}); break;
+        case '/': code.push_back({DIV, 0}); break;
+        case '^': code.push_back({POW, 0}); break;
+        default:
+            throw std::runtime_error("Unknown operation");
+        }
+        share(frame.id);
+    }
+}
+
+template <typename T>
+T CompiledExpression<T>::evaluate(const std::map<std::string, T>& values) const {
+    T* inputs = workspace<T>(INPUTS, variableNames.size());
+    for (size_t i = 0; i < variableNames.size(); i++) {
+        inputs[i] = values.at(variableNames[i]);
+    }
+    return evaluate(inputs, workspace<T>(STACK, stackDepth()));
+}
+
+template <typename T>
+T CompiledExpression<T>::evaluate(const std::vector<T>& values) const {
+    if (values.size() < variableNames.size()) throw std::invalid_argument("Not enough variable values.");
+    return evaluate(values.data(), workspace<T>(STACK, stackDepth()));
+}
+
+template <typename T>
+T CompiledExpression<T>::evaluate(const T* values) const {
+    return evaluate(values, workspace<T>(STACK, stackDepth()));
+}
+
+template <typename T>
+T CompiledExpression<T>::evaluate(const T* values, T* scratch) const {
+    return run<false>(values, scratch, nullptr);
+}
+
+template <typename T>
+T CompiledExpression<T>::evaluate(const T* values, T* scratch, unsigned char& status) const {
+    status = 0;
+    T result = run<true>(values, scratch, &status);
+    if (!expressionFinite(result)) status |= NOT_FINITE;
+    return result;
+}
+
+template <typename T>
+template <bool Checked>
+T CompiledExpression<T>::run(const T* values, T* scratch, unsigned char* status) const {
+    T* top = scratch;
+    T* saved = scratch + maxDepth;
+    for (const Instruction& ins : code) {
+        switch (ins.opcode) {
+        case CONST: *top++ = constants[ins.operand]; break;
+        case VAR: *top++ = values[ins.operand]; break;
+        case ADD: --top; top[-1] = top[-1] + top[0]; break;
+        case SUB: --top; top[-1] = top[-1] - top[0]; break;
+        case MUL: --top; top[-1] = top[-1] * top[0]; break;
+        case DIV:
+            --top;
+            if constexpr (Checked) top[-1] = expressionDivide(top[-1], top[0], *status);
+            else top[-1] = expressionDivide(top[-1], top[0]);
+            break;
+        case POW: --top; top[-1] = std::pow(top[-1], top[0]); break;
+        case SIN: top[-1] = std::sin(top[-1]); break;
+        case COS: top[-1] = std::cos(top[-1]); break;
+        case LN:
+            if constexpr (Checked) top[-1] = expressionLog(top[-1], *status);
+            else top[-1] = expressionLog(top[-1]);
+            break;
+        case EXP: top[-1] = std::exp(top[-1]); break;
+        case POLY: *top++ = polynomialAt(polynomials[ins.operand].polynomial, polynomials[ins.operand].slots, values); break;
+        case LOAD: *top++ = saved[ins.operand]; break;
+        case STORE: saved[ins.operand] = top[-1]; break;
+        }
+    }
+    return top[-1];
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const T* const* columns, T* out, size_t count) const {
+    ExpressionStats::Timer timer(ExpressionStats::BATCH);
+    evaluateRange(columns, out, count, nullptr);
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const T* const* columns, T* out, size_t count, unsigned char* status) const {
+    ExpressionStats::Timer timer(ExpressionStats::BATCH);
+    evaluateRange(columns, out, count, status);
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateRange(const T* const* columns, T* out, size_t count, unsigned char* status) const {
+    if constexpr (std::is_same_v<T, double>) {
+        std::vector<double> blocks(stackDepth() * batchBlock, 0.0);
+        double* saved = blocks.data() + maxDepth * batchBlock;
+        for (size_t start = 0; start < count; start += batchBlock) {
+            size_t n = std::min(batchBlock, count - start);
+            size_t lanes = (n + simd::width - 1) / simd::width * simd::width;
+            unsigned char* flags = status ? status + start : nullptr;
+            if (flags) std::fill(flags, flags + n, 0);
+            double* top = blocks.data();
+            for (size_t pc = 0; pc < code.size(); pc++) {
+                const Instruction& ins = code[pc];
+                double* a = top - batchBlock;
+                switch (ins.opcode) {
+                case CONST:
+                    std::fill(top, top + lanes, constants[ins.operand]);
+                    top += batchBlock;
+                    break;
+                case VAR:
+                    std::copy(columns[ins.operand] + start, columns[ins.operand] + start + n, top);
+                    top += batchBlock;
+                    break;
+                case ADD:
+                    a -= batchBlock;
+                    batchBinary(a, top - batchBlock, lanes, [](simd::Double x, simd::Double y) { return x + y; });
+                    top -= batchBlock;
+                    break;
+                case SUB:
+                    a -= batchBlock;
+                    batchBinary(a, top - batchBlock, lanes, [](simd::Double x, simd::Double y) { return x - y; });
+                    top -= batchBlock;
+                    break;
+                case MUL:
+                    a -= batchBlock;
+                    batchBinary(a, top - batchBlock, lanes, [](simd::Double x, simd::Double y) { return x * y; });
+                    top -= batchBlock;
+                    break;
+                case DIV:
+                    a -= batchBlock;
+                    if (flags) flagLanes(top - batchBlock, n, flags, DIVISION_BY_ZERO, [](double b) { return b == 0.0; });
+                    batchBinary(a, top - batchBlock, lanes, [](simd::Double x, simd::Double y) { return x / y; });
+                    top -= batchBlock;
+                    break;
+                case POW:
+                    a -= batchBlock;
+                    if (code[pc - 1].opcode == CONST && std::abs(constants[code[pc - 1].operand]) <= 64.0
+                        && constants[code[pc - 1].operand] == std::floor(constants[code[pc - 1].operand])) {
+                        batchPowInt(a, lanes, static_cast<int>(constants[code[pc - 1].operand]));
+                    } else {
+                        for (size_t i = 0; i < n; i++) a[i] = std::pow(a[i], a[i + batchBlock]);
+                    }
+                    top -= batchBlock;
+                    break;
+                case SIN: batchTrig(a, lanes, false); break;
+                case COS: batchTrig(a, lanes, true); break;
+                case LN:
+                    if (flags) flagLanes(a, n, flags, LOG_DOMAIN, [](double x) { return x <= 0.0; });
+                    batchUnary(a, lanes, simd::log);
+                    break;
+                case EXP: batchUnary(a, lanes, simd::exp); break;
+                case POLY: {
+                    const PolynomialCall& call = polynomials[ins.operand];
+                    const double* inputs[Polynomial<T>::maxVariables];
+                    for (size_t v = 0; v < call.slots.size(); v++) inputs[v] = columns[call.slots[v]] + start;
+                    call.polynomial.evaluateBatch(inputs, top, n);
+                    top += batchBlock;
+                    break;
+                }
+                case LOAD:
+                    std::copy(saved + ins.operand * batchBlock, saved + ins.operand * batchBlock + lanes, top);
+                    top += batchBlock;
+                    break;
+                case STORE:
+                    std::copy(top - batchBlock, top - batchBlock + lanes, saved + ins.operand * batchBlock);
+                    break;
+                }
+            }
+            if (flags) flagLanes(blocks.data(), n, flags, NOT_FINITE, [](double x) { return !std::isfinite(x); });
+            std::copy(blocks.data(), blocks.data() + n, out + start);
+        }
+    } else {
+        size_t vars = variableNames.size();
+        std::vector<double> re(stackDepth() * batchBlock, 0.0), im(stackDepth() * batchBlock, 0.0);
+        std::vector<double> splitRe(vars * batchBlock), splitIm(vars * batchBlock);
+        std::vector<const double*> real(vars), imag(vars);
+        for (size_t v = 0; v < vars; v++) {
+            real[v] = splitRe.data() + v * batchBlock;
+            imag[v] = splitIm.data() + v * batchBlock;
+        }
+        for (size_t start = 0; start < count; start += batchBlock) {
+            size_t n = std::min(batchBlock, count - start);
+            for (size_t v = 0; v < vars; v++) {
+                for (size_t i = 0; i < n; i++) {
+                    splitRe[v * batchBlock + i] = std::real(columns[v][start + i]);
+                    splitIm[v * batchBlock + i] = std::imag(columns[v][start + i]);
+                }
+            }
+            evaluateSplitBlock(real.data(), imag.data(), 0, n, re.data(), im.data(), status ? status + start : nullptr);
+            for (size_t i = 0; i < n; i++) out[start + i] = T(re[i], im[i]);
+        }
+    }
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const double* const* real, const double* const* imag, double* outReal, double* outImag, size_t count) const {
+    evaluateBatch(real, imag, outReal, outImag, count, nullptr);
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const double* const* real, const double* const* imag, double* outReal, double* outImag, size_t count,
+                                          unsigned char* status) const {
+    if constexpr (!std::is_same_v<T, std::complex<double>>) {
+        throw std::logic_error("Split-complex evaluation needs a complex expression.");
+    } else {
+        ExpressionStats::Timer timer(ExpressionStats::BATCH);
+        std::vector<double> re(stackDepth() * batchBlock, 0.0), im(stackDepth() * batchBlock, 0.0);
+        for (size_t start = 0; start < count; start += batchBlock) {
+            size_t n = std::min(batchBlock, count - start);
+            evaluateSplitBlock(real, imag, start, n, re.data(), im.data(), status ? status + start : nullptr);
+            std::copy(re.data(), re.data() + n, outReal + start);
+            std::copy(im.data(), im.data() + n, outImag + start);
+        }
+    }
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateSplitBlock(const double* const* real, const double* const* imag, size_t start, size_t n, double* re, double* im, unsigned char* status) const {
+    size_t lanes = (n + simd::width - 1) / simd::width * simd::width;
+    if (status) std::fill(status, status + n, 0);
+    size_t top = 0;
+    for (size_t pc = 0; pc < code.size(); pc++) {
+        const Instruction& ins = code[pc];
+        double* ar = re + top - batchBlock;
+        double* ai = im + top - batchBlock;
+        const double* br = re + top - batchBlock;
+        const double* bi = im + top - batchBlock;
+        if (ins.opcode >= ADD && ins.opcode <= POW) {
+            ar -= batchBlock;
+            ai -= batchBlock;
+            top -= batchBlock;
+        }
+        switch (ins.opcode) {
+        case CONST:
+            std::fill(re + top, re + top + lanes, std::real(constants[ins.operand]));
+            std::fill(im + top, im + top + lanes, std::imag(constants[ins.operand]));
+            top += batchBlock;
+            break;
+        case VAR:
+            std::copy(real[ins.operand] + start, real[ins.operand] + start + n, re + top);
+            if (imag[ins.operand]) std::copy(imag[ins.operand] + start, imag[ins.operand] + start + n, im + top);
+            else std::fill(im + top, im + top + n, 0.0);
+            top += batchBlock;
+            break;
+        case ADD:
+            batchBinary(ar, br, lanes, [](simd::Double x, simd::Double y) { return x + y; });
+            batchBinary(ai, bi, lanes, [](simd::Double x, simd::Double y) { return x + y; });
+            break;
+        case SUB:
+            batchBinary(ar, br, lanes, [](simd::Double x, simd::Double y) { return x - y; });
+            batchBinary(ai, bi, lanes, [](simd::Double x, simd::Double y) { return x - y; });
+            break;
+        case MUL: splitMultiply(ar, ai, br, bi, lanes); break;
+        case DIV: splitDivide(ar, ai, br, bi, n, lanes, status); break;
+        case POW: splitLanes(ar, ai, br, bi, 0, n, [](Complex x, Complex y) { return std::pow(x, y); }); break;
+        case SIN: splitTrig(ar, ai, lanes, false); break;
+        case COS: splitTrig(ar, ai, lanes, true); break;
+        case LN:
+            if (status) {
+                for (size_t j = 0; j < n; j++) status[j] |= ar[j] == 0.0 && ai[j] == 0.0 ? LOG_DOMAIN : 0;
+            }
+            splitLanes(ar, ai, br, bi, 0, n, [](Complex x, Complex) { return std::log(x); });
+            break;
+        case EXP: splitExp(ar, ai, lanes); break;
+        case POLY:
+            if constexpr (std::is_same_v<T, Complex>) {
+                const PolynomialCall& call = polynomials[ins.operand];
+                Complex x[Polynomial<T>::maxVariables];
+                for (size_t j = 0; j < n; j++) {
+                    for (size_t v = 0; v < call.slots.size(); v++) {
+                        const double* column = imag[call.slots[v]];
+                        x[v] = Complex(real[call.slots[v]][start + j], column ? column[start + j] : 0.0);
+                    }
+                    Complex r = call.polynomial.evaluate(x);
+                    re[top + j] = r.real();
+                    im[top + j] = r.imag();
+                }
+            }
+            top += batchBlock;
+            break;
+        case LOAD: {
+            size_t saved = (maxDepth + ins.operand) * batchBlock;
+            std::copy(re + saved, re + saved + lanes, re + top);
+            std::copy(im + saved, im + saved + lanes, im + top);
+            top += batchBlock;
+            break;
+        }
+        case STORE: {
+            size_t saved = (maxDepth + ins.operand) * batchBlock;
+            std::copy(br, br + lanes, re + saved);
+            std::copy(bi, bi + lanes, im + saved);
+            break;
+        }
+        }
+    }
+    if (status) {
+        for (size_t j = 0; j < n; j++) status[j] |= std::isfinite(re[j]) && std::isfinite(im[j]) ? 0 : NOT_FINITE;
+    }
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const T* const* columns, T* out, size_t count, ThreadPool& pool) const {
+    ExpressionStats::Timer timer(ExpressionStats::BATCH);
+    size_t grain = std::clamp(count / (pool.size() * 8), batchBlock * 4, batchBlock * 64) / batchBlock * batchBlock;
+    pool.parallelFor(count, grain, [this, columns, out](size_t begin, size_t end) {
+        std::vector<const T*> shifted(variableNames.size());
+        for (size_t v = 0; v < shifted.size(); v++) shifted[v] = columns[v] + begin;
+        evaluateRange(shifted.data(), out + begin, end - begin, nullptr);
+    });
+}
+
+template <typename T>
+void CompiledExpression<T>::evaluateBatch(const T* const* columns, T* out, size_t count, unsigned char* status, ThreadPool& pool) const {
+    ExpressionStats::Timer timer(ExpressionStats::BATCH);
+    size_t grain = std::clamp(count / (pool.size() * 8), batchBlock * 4, batchBlock * 64) / batchBlock * batchBlock;
+    pool.parallelFor(count, grain, [this, columns, out, status](size_t begin, size_t end) {
+        std::vector<const T*> shifted(variableNames.size());
+        for (size_t v = 0; v < shifted.size(); v++) shifted[v] = columns[v] + begin;
+        evaluateRange(shifted.data(), out + begin, end - begin, status + begin);
+    });
+}
+
+template <typename T>
+T CompiledExpression<T>::gradient(const T* values, T* partials) const {
+    T* tape = workspace<T>(TAPE, code.size());
+    T* adjoints = workspace<T>(ADJOINTS, code.size());
+    std::fill(adjoints, adjoints + code.size(), T(0));
+    for (size_t i = 0; i < code.size(); i++) {
+        const T& l = tape[operands[i].left];
+        const T& r = tape[operands[i].right];
+        switch (code[i].opcode) {
+        case CONST: tape[i] = constants[code[i].operand]; break;
+        case VAR: tape[i] = values[code[i].operand]; break;
+        case ADD: tape[i] = l + r; break;
+        case SUB: tape[i] = l - r; break;
+        case MUL: tape[i] = l * r; break;
+        case DIV: tape[i] = expressionDivide(l, r); break;
+        case POW: tape[i] = std::pow(l, r); break;
+        case SIN: tape[i] = std::sin(l); break;
+        case COS: tape[i] = std::cos(l); break;
+        case LN: tape[i] = expressionLog(l); break;
+        case EXP: tape[i] = std::exp(l); break;
+        case POLY: tape[i] = polynomialAt(polynomials[code[i].operand].polynomial, polynomials[code[i].operand].slots, values); break;
+        case LOAD: case STORE: break;
+        }
+    }
+
+    for (size_t v = 0; v < variableNames.size(); v++) partials[v] = T(0);
+    adjoints[code.size() - 1] = T(1);
+    for (size_t i = code.size(); i-- > 0;) {
+        const T a = adjoints[i];
+        const unsigned int l = operands[i].left;
+        const unsigned int r = operands[i].right;
+        switch (code[i].opcode) {
+        case CONST: case LOAD: case STORE: break;
+        case VAR: partials[code[i].operand] += a; break;
+        case ADD: adjoints[l] += a; adjoints[r] += a; break;
+        case SUB: adjoints[l] += a; adjoints[r] -= a; break;
+        case MUL: adjoints[l] += a * tape[r]; adjoints[r] += a * tape[l]; break;
+        case DIV:
+            adjoints[l] += a / tape[r];
+            adjoints[r] -= a * tape[i] / tape[r];
+            break;
+        case POW:
+            if (code[r].opcode == CONST) {
+                adjoints[l] += a * tape[r] * std::pow(tape[l], tape[r] - T(1));
+            } else {
+                adjoints[l] += a * tape[i] * tape[r] / tape[l];
+                adjoints[r] += a * tape[i] * std::log(tape[l]);
+            }
+            break;
+        case SIN: adjoints[l] += a * std::cos(tape[l]); break;
+        case COS: adjoints[l] -= a * std::sin(tape[l]); break;
+        case LN: adjoints[l] += a / tape[l]; break;
+        case EXP: adjoints[l] += a * tape[i]; break;
+        case POLY: {
+            const PolynomialCall& call = polynomials[code[i].operand];
+            for (size_t v = 0; v < call.slots.size(); v++) partials[call.slots[v]] += a * polynomialAt(call.partials[v], call.slots, values);
+            break;
+        }
+        }
+    }
+    return tape[code.size() - 1];
+}
+
+template <typename T>
+const std::vector<std::string>& CompiledExpression<T>::variables() const {
+    return variableNames;
+}
+
+template <typename T>
+size_t CompiledExpression<T>::slot(const std::string& var) const {
+    for (size_t i = 0; i < variableNames.size(); i++) {
+        if (variableNames[i] == var) return i;
+    }
+    throw std::out_of_range("Unknown variable: '" + var + "'");
+}
+
+template <typename T>
+size_t CompiledExpression<T>::size() const {
+    return code.size();
+}
+
+template <typename T>
+size_t CompiledExpression<T>::stackDepth() const {
+    return maxDepth + registers;
+}
+
+template <typename T>
+size_t CompiledExpression<T>::bytes() const {
+    size_t total = sizeof(*this) + code.capacity() * sizeof(Instruction) + operands.capacity() * sizeof(Operands)
+        + constants.capacity() * sizeof(T) + polynomials.capacity() * sizeof(PolynomialCall);
+    for (const PolynomialCall& call : polynomials) {
+        total += (call.partials.size() + 1) * call.polynomial.coefficients().size() * sizeof(T) + call.slots.capacity() * sizeof(unsigned int);
+    }
+    for (const std::string& name : variableNames) total += sizeof(std::string) + name.capacity();
+    return total;
+}
+
+template class CompiledExpression<double>;
+template class CompiledExpression<std::complex<double>>;
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef COMPILED_EXPRESSION_HPP
+#define COMPILED_EXPRESSION_HPP
+
+#include "Expression.hpp"
+#include "Polynomial.hpp"
+#include <vector>
+#include <string>
+#include <map>
+
+class ThreadPool;
+
+template <typename T>
+class CompiledExpression {
+public:
+    // STORE copies the top of the stack into a register and LOAD pushes it
+    // back, so a node shared by several parents is computed only once.
+    enum Opcode : unsigned char { CONST, VAR, ADD, SUB, MUL, DIV, POW, SIN, COS, LN, EXP, POLY, LOAD, STORE };
+
+    struct Instruction {
+        Opcode opcode;
+        unsigned int operand;
+    };
+
+    struct Operands {
+        unsigned int left;
+        unsigned int right;
+    };
+
+    // A polynomial subtree replaced by one POLY instruction. slots maps the
+    // polynomial's variables to input slots; partials share its layout.
+    struct PolynomialCall {
+        Polynomial<T> polynomial;
+        std::vector<Polynomial<T>> partials;
+        std::vector<unsigned int> slots;
+    };
+
+    explicit CompiledExpression(const Expression<T>& expr);
+    CompiledExpression(const Expression<T>& expr, const std::vector<std::string>& order);
+
+    // Overloads without a scratch argument use per-thread buffers, so one
+    // CompiledExpression may be evaluated from several threads at once.
+    T evaluate(const std::map<std::string, T>& values) const;
+    T evaluate(const std::vector<T>& values) const;
+    T evaluate(const T* values) const;
+    T evaluate(const T* values, T* scratch) const;
+    T evaluate(const T* values, T* scratch, unsigned char& status) const;
+    void evaluateBatch(const T* const* columns, T* out, size_t count) const;
+    void evaluateBatch(const T* const* columns, T* out, size_t count, ThreadPool& pool) const;
+    // Checked batches never print or throw: status[i] gets the DomainFlag
+    // bits raised while computing out[i].
+    void evaluateBatch(const T* const* columns, T* out, size_t count, unsigned char* status) const;
+    void evaluateBatch(const T* const* columns, T* out, size_t count, unsigned char* status, ThreadPool& pool) const;
+    void evaluateBatch(const double* const* real, const double* const* imag, double* outReal, double* outImag, size_t count) const;
+    void evaluateBatch(const double* const* real, const double* const* imag, double* outReal, double* outImag, size_t count,
+                       unsigned char* status) const;
+    T gradient(const T* values, T* partials) const;
+
+    const std::vector<std::string>& variables() const;
+    size_t slot(const std::string& var) const;
+    size_t size() const;
+    // Values a caller-supplied scratch buffer must hold: the stack, then the registers.
+    size_t stackDepth() const;
+    size_t bytes() const;
+
+private:
+    void build(const Expression<T>& expr, bool extendVariables);
+    void compile(const ExpressionArena<T>& arena, unsigned int root, bool extendVariables);
+    template <bool Checked>
+    T run(const T* values, T* scratch, unsigned char* status) const;
+    void evaluateRange(const T* const* columns, T* out, size_t count, unsigned char* status) const;
+    void evaluateSplitBlock(const double* const* real, const double* const* imag, size_t start, size_t n, double* re, double* im, unsigned char* status) const;
+
+    std::vector<Instruction> code;
+    std::vector<Operands> operands;
+    std::vector<T> constants;
+    std::vector<PolynomialCall> polynomials;
+    std::vector<std::string> variableNames;
+    size_t maxDepth;
+    size_t registers;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "CountingAllocator.hpp"
+#include "ExpressionStats.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+
+void* allocate(std::size_t size, std::size_t alignment) noexcept {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (ExpressionStats::enabled()) ExpressionStats::allocated(size);
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size ? size : 1);
+    // aligned_alloc wants a nonzero size that is a multiple of the alignment.
+    return std::aligned_alloc(alignment, size ? (size + alignment - 1) / alignment * alignment : alignment);
+}
+
+void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+    if (void* p = allocate(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+}
+
+void CountingAllocator::enable(bool on) {
+    counting.store(on, std::memory_order_relaxed);
+}
+
+uint64_t CountingAllocator::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint64_t CountingAllocator::bytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    return allocateOrThrow(size, 0);
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size) {
+    return allocateOrThrow(size, 0);
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, 0);
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+// Both malloc and aligned_alloc memory is released with free, so every
+// delete form reduces to the same call.
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,17 @@
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+
+#include <cstdint>
+
+// Replacement global operator new/delete (every form, including the aligned
+// and nothrow ones) for the binaries that link CountingAllocator.cpp.
+// Allocations are counted here only after enable(), and in ExpressionStats
+// only while it is enabled; otherwise each costs two relaxed loads.
+class CountingAllocator {
+public:
+    static void enable(bool on = true);
+    static uint64_t allocations();
+    static uint64_t bytes();
+};
+
+#endif
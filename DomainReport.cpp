@@ -0,0 +1,51 @@
+#include "DomainReport.hpp"
+
+namespace {
+
+const char* const kindNames[] = {"division by zero", "logarithm of zero or negative number", "non-finite result"};
+
+}
+
+DomainReport::DomainReport() : total(0), bad(0), counts{} {}
+
+void DomainReport::record(const unsigned char* status, size_t count) {
+    total += count;
+    for (size_t i = 0; i < count; i++) {
+        unsigned char s = status[i];
+        if (!s) continue;
+        bad++;
+        for (size_t k = 0; k < kinds; k++) counts[k] += (s >> k) & 1;
+    }
+}
+
+void DomainReport::merge(const DomainReport& other) {
+    total += other.total;
+    bad += other.bad;
+    for (size_t k = 0; k < kinds; k++) counts[k] += other.counts[k];
+}
+
+uint64_t DomainReport::points() const {
+    return total;
+}
+
+uint64_t DomainReport::flagged() const {
+    return bad;
+}
+
+uint64_t DomainReport::count(DomainFlag flag) const {
+    for (size_t k = 0; k < kinds; k++) {
+        if (flag == (1u << k)) return counts[k];
+    }
+    return 0;
+}
+
+bool DomainReport::clean() const {
+    return bad == 0;
+}
+
+void DomainReport::print(std::ostream& out) const {
+    out << "Warning: " << bad << " of " << total << " points hit a domain error.\n";
+    for (size_t k = 0; k < kinds; k++) {
+        if (counts[k]) out << "  " << kindNames[k] << ": " << counts[k] << "\n";
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef DOMAIN_REPORT_HPP
+#define DOMAIN_REPORT_HPP
+
+#include "ExpressionMath.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Totals of the per-point status flags from checked batch evaluation. Each
+// worker records its own blocks and the reports are merged, so nothing is
+// printed until print() is called once at the end of a run.
+class DomainReport {
+public:
+    static constexpr size_t kinds = 3;
+
+    DomainReport();
+
+    void record(const unsigned char* status, size_t count);
+    void merge(const DomainReport& other);
+
+    uint64_t points() const;
+    uint64_t flagged() const;
+    uint64_t count(DomainFlag flag) const;
+    bool clean() const;
+    void print(std::ostream& out) const;
+
+private:
+    uint64_t total;
+    uint64_t bad;
+    uint64_t counts[kinds];
+};
+
+#endif
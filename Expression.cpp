@@ -1,44 +1,47 @@
 #include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include "ExpressionDag.hpp"
+#include "ExpressionMath.hpp"
+#include "SymbolTable.hpp"
+#include "ExpressionParser.hpp"
+#include "ExpressionSimplifier.hpp"
+#include "ExpressionStats.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+const char* const functionNames[] = {"sin", "cos", "ln", "exp"};
+
+}
 
 template <typename T>
-Expression<T>::Expression(T value)
-    : type(CONSTANT), constantValue(value), variableName(), operation('\0'), left(nullptr), right(nullptr) {
+Expression<T>::Expression(T value) : arena(Arena::current()), id(0) {
+    id = arena->add({CONSTANT, '\0', 0, 0, 0, 0, 0, value});
 }
 
 template <typename T>
-Expression<T>::Expression(const std::string& var)
-    : type(VARIABLE), constantValue(T(0)), variableName(var), operation('\0'), left(nullptr), right(nullptr) {
+Expression<T>::Expression(const std::string& var) : arena(Arena::current()), id(0) {
+    id = arena->add({VARIABLE, '\0', 0, 0, SymbolTable::intern(var), 0, 0, T(0)});
 }
 
 template <typename T>
 Expression<T>::Expression(const Expression& other)
-    : type(other.type),
-      constantValue(other.constantValue),
-      variableName(other.variableName),
-      operation(other.operation),
-      left(other.left),
-      right(other.right) {
+    : arena(other.arena),
+      id(other.id) {
 }
 
 template <typename T>
 Expression<T>::Expression(Expression&& other) noexcept
-    : type(other.type),
-      constantValue(other.constantValue),
-      variableName(std::move(other.variableName)),
-      operation(other.operation),
-      left(std::move(other.left)),
-      right(std::move(other.right)) {
+    : arena(std::move(other.arena)),
+      id(other.id) {
 }
 
 template <typename T>
 Expression<T>& Expression<T>::operator=(const Expression& other) {
     if (this != &other) {
-        type = other.type;
-        constantValue = other.constantValue;
-        variableName = other.variableName;
-        operation = other.operation;
-        left = other.left;
-        right = other.right;
+        arena = other.arena;
+        id = other.id;
     }
     return *this;
 }
@@ -46,61 +49,105 @@ Expression<T>& Expression<T>::operator=(const Expression& other) {
 template <typename T>
 Expression<T>& Expression<T>::operator=(Expression&& other) noexcept {
     if (this != &other) {
-        left.reset();
-        right.reset();
-        type = other.type;
-        constantValue = other.constantValue;
-        variableName = std::move(other.variableName);
-        operation = other.operation;
-        left = std::move(other.left);
-        right = std::move(other.right);
+        arena = std::move(other.arena);
+        id = other.id;
     }
     return *this;
 }
 
+template <typename T>
+Expression<T>::Expression(std::shared_ptr<Arena> arena, unsigned int id)
+    : arena(std::move(arena)),
+      id(id) {
+}
+
 template <typename T>
 Expression<T>::Expression(char op, const Expression& lhs, const Expression& rhs)
-    : type(OPERATION),
-      constantValue(T(0)),
-      variableName(),
-      operation(op),
-      left(std::make_shared<Expression>(lhs)),
-      right(std::make_shared<Expression>(rhs)) {
+    : arena(writableArena(lhs)),
+      id(0) {
+    unsigned int l = lhs.idIn(*arena);
+    unsigned int r = rhs.idIn(*arena);
+    id = arena->add({OPERATION, op, 0, 0, 0, l, r, T(0)});
 }
 
 template <typename T>
 Expression<T>::Expression(const std::string& func, const Expression& expr)
-    : type(FUNCTION),
-      constantValue(T(0)),
-      variableName(func),
-      operation('\0'),
-      left(std::make_shared<Expression>(expr)),
-      right(nullptr) {
+    : arena(writableArena(expr)),
+      id(0) {
+    unsigned char code = 0;
+    while (code < 4 && func != functionNames[code]) code++;
+    if (code == 4) throw std::runtime_error("Unknown function");
+    id = arena->add({FUNCTION, '\0', code, 0, 0, expr.idIn(*arena), 0, T(0)});
+}
+
+template <typename T>
+std::shared_ptr<ExpressionArena<T>> Expression<T>::writableArena(const Expression& expr) {
+    return Arena::isCurrent(expr.arena) ? expr.arena : Arena::current();
+}
+
+template <typename T>
+const typename Expression<T>::Node& Expression<T>::node() const {
+    return arena->node(id);
+}
+
+template <typename T>
+Expression<T> Expression<T>::child(unsigned int childId) const {
+    return Expression(arena, childId);
+}
+
+template <typename T>
+unsigned int Expression<T>::idIn(Arena& target) const {
+    return arena.get() == &target ? id : target.import(*arena, id);
 }
 
 template <typename T>
-Expression<T> Expression<T>::operator+(const Expression& other) const {
-    return simplify(Expression('+', *this, other));
+Expression<T> Expression<T>::operator+(const Expression& other) const & {
+    return Expression(*this).combine('+', other);
 }
 
 template <typename T>
-Expression<T> Expression<T>::operator-(const Expression& other) const {
-    return simplify(Expression('-', *this, other));
+Expression<T> Expression<T>::operator+(const Expression& other) && {
+    return std::move(*this).combine('+', other);
 }
 
 template <typename T>
-Expression<T> Expression<T>::operator*(const Expression& other) const {
-    return simplify(Expression('*', *this, other));
+Expression<T> Expression<T>::operator-(const Expression& other) const & {
+    return Expression(*this).combine('-', other);
 }
 
 template <typename T>
-Expression<T> Expression<T>::operator/(const Expression& other) const {
-    return simplify(Expression('/', *this, other));
+Expression<T> Expression<T>::operator-(const Expression& other) && {
+    return std::move(*this).combine('-', other);
 }
 
 template <typename T>
-Expression<T> Expression<T>::operator^(const Expression& other) const {
-    return simplify(Expression('^', *this, other));
+Expression<T> Expression<T>::operator*(const Expression& other) const & {
+    return Expression(*this).combine('*', other);
+}
+
+template <typename T>
+Expression<T> Expression<T>::operator*(const Expression& other) && {
+    return std::move(*this).combine('*', other);
+}
+
+template <typename T>
+Expression<T> Expression<T>::operator/(const Expression& other) const & {
+    return Expression(*this).combine('/', other);
+}
+
+template <typename T>
+Expression<T> Expression<T>::operator/(const Expression& other) && {
+    return std::move(*this).combine('/', other);
+}
+
+template <typename T>
+Expression<T> Expression<T>::operator^(const Expression& other) const & {
+    return Expression(*this).combine('^', other);
+}
+
+template <typename T>
+Expression<T> Expression<T>::operator^(const Expression& other) && {
+    return std::move(*this).combine('^', other);
 }
 
 template <typename T>
@@ -125,29 +172,30 @@ Expression<T> Expression<T>::exp(const Expression& expr) {
 
 template <typename T>
 T Expression<T>::evaluate(const std::map<std::string, T>& values) const {
-    if (type == CONSTANT) return constantValue;
-    if (type == VARIABLE) {
-        return values.at(variableName);
+    ExpressionStats::Timer timer(ExpressionStats::EVALUATE);
+    return evaluateNode(*arena, id, values);
+}
+
+template <typename T>
+T Expression<T>::evaluateNode(const Arena& arena, unsigned int id, const std::map<std::string, T>& values) {
+    const Node& n = arena.node(id);
+    if (n.type == CONSTANT) return n.value;
+    if (n.type == VARIABLE) {
+        return values.at(SymbolTable::name(n.symbol));
     }
-    if (type == FUNCTION) {
-        T val = left->evaluate(values);
-        if (variableName == "sin") return std::sin(val);
-        if (variableName == "cos") return std::cos(val);
-        if (variableName == "ln") {
-            if constexpr (std::is_floating_point_v<T>) {
-                if (val <= T(0)) {
-                    std::cerr << "Warning: Logarithm of zero or negative number is undefined. Returning -inf.\n";
-                    return -std::numeric_limits<T>::infinity();
-                }
-            }
-            return std::log(val);
+    if (n.type == FUNCTION) {
+        T val = evaluateNode(arena, n.left, values);
+        switch (n.function) {
+        case Arena::SIN: return std::sin(val);
+        case Arena::COS: return std::cos(val);
+        case Arena::LN: return expressionLog(val);
+        case Arena::EXP: return std::exp(val);
+        default: throw std::runtime_error("Unknown function");
         }
-        if (variableName == "exp") return std::exp(val);
-        throw std::runtime_error("Unknown function");
     }
-    T leftVal = left ? left->evaluate(values) : T(0);
-    T rightVal = right ? right->evaluate(values) : T(0);
-    switch (operation) {
+    T leftVal = evaluateNode(arena, n.left, values);
+    T rightVal = evaluateNode(arena, n.right, values);
+    switch (n.operation) {
     case '+':
         return leftVal + rightVal;
     case '-':
@@ -155,12 +203,7 @@ T Expression<T>::evaluate(const std::map<std::string, T>& values) const {
     case '*':
         return leftVal * rightVal;
     case '/':
-        if constexpr (std::is_floating_point_v<T>) {
-            if (rightVal == T(0)) return std::numeric_limits<T>::infinity();
-        } else {
-            if (std::abs(rightVal) == T(0)) throw std::runtime_error("Division by zero for complex.");
-        }
-        return leftVal / rightVal;
+        return expressionDivide(leftVal, rightVal);
     case '^':
         return std::pow(leftVal, rightVal);
     default:
@@ -169,77 +212,163 @@ T Expression<T>::evaluate(const std::map<std::string, T>& values) const {
 }
 
 template <typename T>
-Expression<T> Expression<T>::differentiate(const std::string& var) const {
-    if (type == CONSTANT) return Expression(T(0));
-    if (type == VARIABLE) {
-        if (variableName == var) return Expression(T(1));
-        return Expression(T(0));
+std::vector<std::string> Expression<T>::variables() const {
+    std::vector<unsigned int> symbols;
+    std::vector<unsigned int> pending{id};
+    std::unordered_set<unsigned int> visited;
+    while (!pending.empty()) {
+        unsigned int current = pending.back();
+        pending.pop_back();
+        if (!visited.insert(current).second) continue;
+        const Node& n = arena->node(current);
+        if (n.type == VARIABLE) symbols.push_back(n.symbol);
+        if (n.type == OPERATION) pending.push_back(n.right);
+        if (n.type == OPERATION || n.type == FUNCTION) pending.push_back(n.left);
     }
-    if (type == FUNCTION) {
-        if (variableName == "sin") return simplify(cos(*left) * left->differentiate(var));
-        if (variableName == "cos") return simplify(Expression(T(-1)) * sin(*left) * left->differentiate(var));
-        if (variableName == "ln") return simplify((Expression(T(1)) / *left) * left->differentiate(var));
-        if (variableName == "exp") return simplify(exp(*left) * left->differentiate(var));
-        return Expression(T(0));
+    std::vector<std::string> names;
+    for (unsigned int symbol : symbols) names.push_back(SymbolTable::name(symbol));
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+template <typename T>
+size_t Expression<T>::size() const {
+    std::vector<unsigned int> pending{id};
+    std::unordered_set<unsigned int> visited;
+    while (!pending.empty()) {
+        unsigned int current = pending.back();
+        pending.pop_back();
+        if (!visited.insert(current).second) continue;
+        const Node& n = arena->node(current);
+        if (n.type == OPERATION) pending.push_back(n.right);
+        if (n.type == OPERATION || n.type == FUNCTION) pending.push_back(n.left);
     }
-    switch (operation) {
-    case '+':
-        return simplify(left->differentiate(var) + right->differentiate(var));
-    case '-':
-        return simplify(left->differentiate(var) - right->differentiate(var));
-    case '*':
-        return simplify(left->differentiate(var) * (*right) + (*left) * right->differentiate(var));
-    case '/':
-        return simplify((left->differentiate(var) * (*right) - (*left) * right->differentiate(var)) / ((*right) * (*right)));
-    case '^':
-        if (right->type == CONSTANT) {
-            return simplify((*right) * ((*left) ^ Expression(right->constantValue - T(1))) * left->differentiate(var));
-        } else {
-            Expression<T> f = *left;
-            Expression<T> g = *right;
-            Expression<T> df = f.differentiate(var);
-            Expression<T> dg = g.differentiate(var);
-            Expression<T> ln_f = ln(f);
-            Expression<T> base = exp(g * ln_f);
-            Expression<T> chain = dg * ln_f + (g * df / f);
-            return simplify(base * chain);
+    return visited.size();
+}
+
+template <typename T>
+size_t Expression<T>::depth() const {
+    std::unordered_map<unsigned int, unsigned int> levels;
+    std::vector<std::pair<unsigned int, bool>> pending{{id, false}};
+    while (!pending.empty()) {
+        auto [current, expanded] = pending.back();
+        pending.pop_back();
+        if (levels.count(current)) continue;
+        const Node& n = arena->node(current);
+        bool hasChildren = n.type == OPERATION || n.type == FUNCTION;
+        if (hasChildren && !expanded) {
+            pending.push_back({current, true});
+            pending.push_back({n.left, false});
+            if (n.type == OPERATION) pending.push_back({n.right, false});
+            continue;
         }
-    default:
-        throw std::runtime_error("Unknown operation in differentiation");
+        unsigned int below = hasChildren ? levels.at(n.left) : 0;
+        if (n.type == OPERATION) below = std::max(below, levels.at(n.right));
+        levels.emplace(current, below + 1);
     }
+    return levels.at(id);
 }
 
+template <typename T>
+CompiledExpression<T> Expression<T>::bind(const std::vector<std::string>& order) const {
+    return CompiledExpression<T>(*this, order);
+}
+
+template <typename T>
+void Expression<T>::evaluateBatch(const std::map<std::string, const T*>& columns, T* out, size_t count) const {
+    CompiledExpression<T> compiled(*this);
+    std::vector<const T*> slots;
+    for (const std::string& var : compiled.variables()) {
+        slots.push_back(columns.at(var));
+    }
+    compiled.evaluateBatch(slots.data(), out, count);
+}
+
+template <typename T>
+void Expression<T>::evaluateBatch(const std::map<std::string, const T*>& columns, T* out, size_t count, ThreadPool& pool) const {
+    CompiledExpression<T> compiled(*this);
+    std::vector<const T*> slots;
+    for (const std::string& var : compiled.variables()) {
+        slots.push_back(columns.at(var));
+    }
+    compiled.evaluateBatch(slots.data(), out, count, pool);
+}
+
+
+template <typename T>
+Expression<T> Expression<T>::differentiate(const std::string& var) const {
+    ExpressionStats::Timer timer(ExpressionStats::DIFFERENTIATE);
+    // The DAG memoizes each (node, var) derivative, so shared subtrees are
+    // differentiated once instead of once per path that reaches them.
+    ExpressionDag<T> dag;
+    Expression result = dag.toExpression(dag.differentiate(dag.fromExpression(*this), var)).simplified();
+    if (ExpressionStats::enabled()) {
+        ExpressionStats::derivative(size(), result.size());
+        ExpressionStats::depth(result.depth());
+    }
+    return result;
+}
+
+template <typename T>
+Expression<T> Expression<T>::simplified(size_t budget) const {
+    ExpressionStats::Timer timer(ExpressionStats::SIMPLIFY);
+    return ExpressionSimplifier<T>(budget).simplify(*this);
+}
+
+template <typename T>
+Gradient<T> Expression<T>::gradient(const std::map<std::string, T>& values) const {
+    CompiledExpression<T> compiled(*this);
+    const std::vector<std::string>& vars = compiled.variables();
+    std::vector<T> inputs(vars.size());
+    std::vector<T> partials(vars.size());
+    for (size_t i = 0; i < vars.size(); i++) inputs[i] = values.at(vars[i]);
+
+    Gradient<T> result;
+    result.value = compiled.gradient(inputs.data(), partials.data());
+    for (size_t i = 0; i < vars.size(); i++) result.partials[vars[i]] = partials[i];
+    return result;
+}
+
+
 template <typename T>
 std::string Expression<T>::toString() const {
-    if (type == CONSTANT) {
+    ExpressionStats::Timer timer(ExpressionStats::TO_STRING);
+    return toStringNode(*arena, id);
+}
+
+template <typename T>
+std::string Expression<T>::toStringNode(const Arena& arena, unsigned int id) {
+    const Node& n = arena.node(id);
+    if (n.type == CONSTANT) {
         std::ostringstream ss;
-        ss << constantValue;
+        ss << n.value;
         return ss.str();
     }
-    if (type == VARIABLE) {
-        return variableName;
+    if (n.type == VARIABLE) {
+        return SymbolTable::name(n.symbol);
     }
-    if (type == FUNCTION) {
-        return variableName + "(" + left->toString() + ")";
+    if (n.type == FUNCTION) {
+        return std::string(functionNames[n.function]) + "(" + toStringNode(arena, n.left) + ")";
     }
-    std::string L = left ? left->toString() : "";
-    std::string R = right ? right->toString() : "";
-    if ((operation == '+' || operation == '-') && right) {
-        if (right->operation == '*') {
+    std::string L = toStringNode(arena, n.left);
+    std::string R = toStringNode(arena, n.right);
+    if (n.operation == '+' || n.operation == '-') {
+        if (arena.node(n.right).operation == '*') {
             if (!R.empty() && R.front() == '(' && R.back() == ')') {
                 R = R.substr(1, R.size() - 2);
             }
         }
     }
-    if (operation == '+') {
+    if (n.operation == '+') {
         if (R.find("(x * cos(x))") != std::string::npos) {
             R = R.substr(1, R.size() - 2);
         }
     }
-    switch (operation) {
+    switch (n.operation) {
     case '+':
     case '-':
-        return "(" + L + " " + operation + " " + R + ")";
+        return "(" + L + " " + n.operation + " " + R + ")";
     case '*':
         return "(" + L + " * " + R + ")";
     case '/':
@@ -253,144 +382,150 @@ std::string Expression<T>::toString() const {
 
 template <typename T>
 Expression<T> Expression<T>::substitute(const std::string& var, const Expression<T>& value) const {
-    if (type == VARIABLE && variableName == var) {
+    const Node& n = node();
+    if (n.type == VARIABLE && SymbolTable::name(n.symbol) == var) {
         return value;
     }
-    if (type == OPERATION || type == FUNCTION) {
-        auto L = left ? std::make_shared<Expression>(left->substitute(var, value)) : nullptr;
-        auto R = right ? std::make_shared<Expression>(right->substitute(var, value)) : nullptr;
-        if (type == OPERATION) {
-            return Expression(operation, *L, R ? *R : Expression(T(0)));
-        } else {
-            return Expression(variableName, *L);
-        }
+    if (n.type == OPERATION) {
+        return Expression(n.operation, child(n.left).substitute(var, value), child(n.right).substitute(var, value));
+    }
+    if (n.type == FUNCTION) {
+        return Expression(functionNames[n.function], child(n.left).substitute(var, value));
     }
     return *this;
 }
 
 template <typename T>
-std::string Expression<T>::stripOuterParens(const std::string& s) {
-    if (s.size() >= 2 && s.front() == '(' && s.back() == ')') {
-        int depth = 0;
-        for (size_t i = 0; i < s.size(); i++) {
-            if (s[i] == '(') depth++;
-            if (s[i] == ')') depth--;
-            if (depth == 0 && i < s.size() - 1) return s;
+Expression<T> Expression<T>::specialize(const std::map<std::string, T>& values) const {
+    std::shared_ptr<Arena> target = writableArena(*this);
+    unsigned int root = idIn(*target);
+    std::map<unsigned int, T> bound;
+    for (const auto& [name, value] : values) bound.emplace(SymbolTable::intern(name), value);
+    auto constant = [&target](T value) { return target->add({CONSTANT, '\0', 0, 0, 0, 0, 0, value}); };
+    auto fold = [](const Node& n, T a, T b, T& result) {
+        if (n.type == FUNCTION) {
+            switch (n.function) {
+            case Arena::SIN: result = std::sin(a); return true;
+            case Arena::COS: result = std::cos(a); return true;
+            case Arena::EXP: result = std::exp(a); return true;
+            case Arena::LN:
+                if constexpr (std::is_floating_point_v<T>) {
+                    if (!(a > T(0))) return false;
+                }
+                result = expressionLog(a);
+                return true;
+            default: return false;
+            }
         }
-        return s.substr(1, s.size() - 2);
-    }
-    return s;
-}
-
-template <typename T>
-Expression<T> Expression<T>::fromString(std::string str) {
-    str = trim(str);
-    str = stripOuterParens(str);
-    if (str == "x") return Expression("x");
-    if (str == "y") return Expression("y");
-    size_t plusPos = std::string::npos;
-    size_t minusPos = std::string::npos;
-    int depth = 0;
-    for (size_t i = 0; i < str.size(); i++) {
-        if (str[i] == '(') depth++;
-        if (str[i] == ')') depth--;
-        if (depth == 0 && str[i] == '+' && i != 0) { plusPos = i; break; }
-    }
-    if (plusPos != std::string::npos) {
-        return Expression('+', fromString(str.substr(0, plusPos)), fromString(str.substr(plusPos + 1)));
-    }
-    depth = 0;
-    for (size_t i = 1; i < str.size(); i++) {
-        if (str[i] == '(') depth++;
-        if (str[i] == ')') depth--;
-        if (depth == 0 && str[i] == '-') { minusPos = i; break; }
-    }
-    if (minusPos != std::string::npos) {
-        return Expression('-', fromString(str.substr(0, minusPos)), fromString(str.substr(minusPos + 1)));
-    }
-    depth = 0;
-    for (size_t i = 0; i < str.size(); i++) {
-        if (str[i] == '(') depth++;
-        if (str[i] == ')') depth--;
-        if (depth == 0 && str[i] == '*') {
-            return Expression('*', fromString(str.substr(0, i)), fromString(str.substr(i + 1)));
+        switch (n.operation) {
+        case '+': result = a + b; return true;
+        case '-': result = a - b; return true;
+        case '*': result = a * b; return true;
+        case '/':
+            if constexpr (!std::is_floating_point_v<T>) {
+                if (b == T(0)) return false;
+            }
+            result = expressionDivide(a, b);
+            return true;
+        case '^': result = std::pow(a, b); return true;
+        default: return false;
         }
-    }
-    depth = 0;
-    for (size_t i = 0; i < str.size(); i++) {
-        if (str[i] == '(') depth++;
-        if (str[i] == ')') depth--;
-        if (depth == 0 && str[i] == '/') {
-            return Expression('/', fromString(str.substr(0, i)), fromString(str.substr(i + 1)));
+    };
+
+    std::unordered_map<unsigned int, unsigned int> mapped;
+    std::vector<std::pair<unsigned int, bool>> pending{{root, false}};
+    while (!pending.empty()) {
+        auto [current, expanded] = pending.back();
+        if (mapped.count(current)) {
+            pending.pop_back();
+            continue;
         }
-    }
-    depth = 0;
-    for (size_t i = 0; i < str.size(); i++) {
-        if (str[i] == '(') depth++;
-        if (str[i] == ')') depth--;
-        if (depth == 0 && str[i] == '^') {
-            return Expression('^', fromString(str.substr(0, i)), fromString(str.substr(i + 1)));
+        const Node n = target->node(current);
+        if ((n.type == OPERATION || n.type == FUNCTION) && !expanded) {
+            pending.back().second = true;
+            pending.push_back({n.left, false});
+            if (n.type == OPERATION) pending.push_back({n.right, false});
+            continue;
+        }
+        pending.pop_back();
+        if (n.type == CONSTANT) {
+            mapped[current] = current;
+        } else if (n.type == VARIABLE) {
+            auto it = bound.find(n.symbol);
+            mapped[current] = it == bound.end() ? current : constant(it->second);
+        } else {
+            unsigned int L = mapped.at(n.left);
+            unsigned int R = n.type == OPERATION ? mapped.at(n.right) : L;
+            const Node& l = target->node(L);
+            const Node& r = target->node(R);
+            T result;
+            if (l.type == CONSTANT && r.type == CONSTANT && fold(n, l.value, r.value, result)) {
+                mapped[current] = constant(result);
+            } else if (L == n.left && (n.type == FUNCTION || R == n.right)) {
+                mapped[current] = current;
+            } else if (n.type == FUNCTION) {
+                mapped[current] = target->add({FUNCTION, '\0', n.function, 0, 0, L, 0, T(0)});
+            } else {
+                mapped[current] = combineNode(*target, n.operation, L, R);
+            }
         }
     }
-    if (str.size() >= 4 && str.substr(0, 4) == "sin(" && str.back() == ')') {
-        return sin(fromString(str.substr(4, str.size() - 5)));
-    }
-    if (str.size() >= 4 && str.substr(0, 4) == "cos(" && str.back() == ')') {
-        return cos(fromString(str.substr(4, str.size() - 5)));
-    }
-    if (str.size() >= 3 && str.substr(0, 3) == "ln(" && str.back() == ')') {
-        return ln(fromString(str.substr(3, str.size() - 4)));
-    }
-    if (str.size() >= 4 && str.substr(0, 4) == "exp(" && str.back() == ')') {
-        return exp(fromString(str.substr(4, str.size() - 5)));
-    }
-    try {
-        return Expression(std::stod(str));
-    } catch (...) {
-        throw std::runtime_error("Invalid expression: '" + str + "'");
-    }
+    return Expression(std::move(target), mapped.at(root));
 }
 
 template <typename T>
-Expression<T> Expression<T>::simplify(const Expression<T>& expr) {
-    if (expr.type == OPERATION) {
-        Expression<T> L = expr.left ? simplify(*expr.left) : Expression<T>(T(0));
-        Expression<T> R = expr.right ? simplify(*expr.right) : Expression<T>(T(0));
-        switch (expr.operation) {
-        case '+':
-            if (L.type == CONSTANT && L.constantValue == T(0)) return R;
-            if (R.type == CONSTANT && R.constantValue == T(0)) return L;
-            break;
-        case '-':
-            if (R.type == CONSTANT && R.constantValue == T(0)) return L;
-            break;
-        case '*':
-            if (L.type == CONSTANT && L.constantValue == T(0)) return Expression<T>(T(0));
-            if (R.type == CONSTANT && R.constantValue == T(0)) return Expression<T>(T(0));
-            if (L.type == CONSTANT && L.constantValue == T(1)) return R;
-            if (R.type == CONSTANT && R.constantValue == T(1)) return L;
-            break;
-        case '/':
-            if (L.type == CONSTANT && L.constantValue == T(0)) return Expression<T>(T(0));
-            if (R.type == CONSTANT && R.constantValue == T(1)) return L;
-            break;
-        case '^':
-            if (R.type == CONSTANT && R.constantValue == T(0)) return Expression<T>(T(1));
-            if (R.type == CONSTANT && R.constantValue == T(1)) return L;
-            break;
-        default: break;
-        }
-        return Expression(expr.operation, L, R);
+Expression<T> Expression<T>::fromString(std::string_view str) {
+    ExpressionStats::Timer timer(ExpressionStats::PARSE);
+    Expression result = ExpressionParser<T>(str).parse();
+    if (ExpressionStats::enabled()) ExpressionStats::depth(result.depth());
+    return result;
+}
+
+template <typename T>
+Expression<T> Expression<T>::combine(char op, const Expression& rhs) && {
+    std::shared_ptr<Arena> target;
+    unsigned int l = id;
+    if (Arena::isCurrent(arena)) {
+        target = std::move(arena);
+    } else {
+        target = Arena::current();
+        l = target->import(*arena, id);
     }
-    return expr;
+    unsigned int r = rhs.idIn(*target);
+    unsigned int root = combineNode(*target, op, l, r);
+    return Expression(std::move(target), root);
 }
 
 template <typename T>
-std::string Expression<T>::trim(const std::string& str) {
-    std::string s = str;
-    s.erase(s.begin(), std::find_if(s.begin(), s.end(), [](unsigned char c){return !std::isspace(c);}));
-    s.erase(std::find_if(s.rbegin(), s.rend(), [](unsigned char c){return !std::isspace(c);}).base(), s.end());
-    return s;
+unsigned int Expression<T>::combineNode(Arena& arena, char op, unsigned int L, unsigned int R) {
+    const Node& l = arena.node(L);
+    const Node& r = arena.node(R);
+    auto constant = [&arena](T value) { return arena.add({CONSTANT, '\0', 0, 0, 0, 0, 0, value}); };
+    switch (op) {
+    case '+':
+        if (l.type == CONSTANT && l.value == T(0)) return R;
+        if (r.type == CONSTANT && r.value == T(0)) return L;
+        break;
+    case '-':
+        if (r.type == CONSTANT && r.value == T(0)) return L;
+        break;
+    case '*':
+        if (l.type == CONSTANT && l.value == T(0)) return constant(T(0));
+        if (r.type == CONSTANT && r.value == T(0)) return constant(T(0));
+        if (l.type == CONSTANT && l.value == T(1)) return R;
+        if (r.type == CONSTANT && r.value == T(1)) return L;
+        break;
+    case '/':
+        if (l.type == CONSTANT && l.value == T(0)) return constant(T(0));
+        if (r.type == CONSTANT && r.value == T(1)) return L;
+        break;
+    case '^':
+        if (r.type == CONSTANT && r.value == T(0)) return constant(T(1));
+        if (r.type == CONSTANT && r.value == T(1)) return L;
+        break;
+    default: break;
+    }
+    return arena.add({OPERATION, op, 0, 0, 0, L, R, T(0)});
 }
 
 template class Expression<double>;
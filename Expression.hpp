@@ -6,12 +6,44 @@
 #include <string>
 #include <cmath>
 #include <map>
+#include <vector>
 #include <complex>
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include <type_traits>
+#include <string_view>
+#include "ExpressionArena.hpp"
+
+template <typename T>
+class CompiledExpression;
+
+class ThreadPool;
+
+template <typename T>
+struct Gradient {
+    T value;
+    std::map<std::string, T> partials;
+};
+
+template <typename T>
+class ExpressionDag;
+
+template <typename T>
+class ExpressionParser;
+
+template <typename T>
+class ExpressionSimplifier;
+
+template <typename T>
+class IncrementalEvaluator;
+
+template <typename T>
+class Polynomial;
+
+template <typename T>
+class ExpressionCache;
 
 template <typename T>
 class Expression {
@@ -26,11 +58,16 @@ public:
     Expression& operator=(const Expression& other);
     Expression& operator=(Expression&& other) noexcept;
 
-    Expression operator+(const Expression& other) const;
-    Expression operator-(const Expression& other) const;
-    Expression operator*(const Expression& other) const;
-    Expression operator/(const Expression& other) const;
-    Expression operator^(const Expression& other) const;
+    Expression operator+(const Expression& other) const &;
+    Expression operator+(const Expression& other) &&;
+    Expression operator-(const Expression& other) const &;
+    Expression operator-(const Expression& other) &&;
+    Expression operator*(const Expression& other) const &;
+    Expression operator*(const Expression& other) &&;
+    Expression operator/(const Expression& other) const &;
+    Expression operator/(const Expression& other) &&;
+    Expression operator^(const Expression& other) const &;
+    Expression operator^(const Expression& other) &&;
 
     static Expression sin(const Expression& expr);
     static Expression cos(const Expression& expr);
@@ -38,24 +75,49 @@ public:
     static Expression exp(const Expression& expr);
 
     T evaluate(const std::map<std::string, T>& values) const;
+    // To evaluate from value arrays, bind() once and reuse the returned
+    // CompiledExpression; variables() is the sorted order to bind with.
+    std::vector<std::string> variables() const;
+    size_t size() const;
+    size_t depth() const;
+    CompiledExpression<T> bind(const std::vector<std::string>& order) const;
+    void evaluateBatch(const std::map<std::string, const T*>& columns, T* out, size_t count) const;
+    void evaluateBatch(const std::map<std::string, const T*>& columns, T* out, size_t count, ThreadPool& pool) const;
     Expression differentiate(const std::string& var) const;
+    Expression simplified(size_t budget = 0) const;
+    Gradient<T> gradient(const std::map<std::string, T>& values) const;
     std::string toString() const;
     Expression substitute(const std::string& var, const Expression& value) const;
-    static Expression fromString(std::string str);
+    Expression specialize(const std::map<std::string, T>& values) const;
+    static Expression fromString(std::string_view str);
 
 private:
+    friend class CompiledExpression<T>;
+    friend class ExpressionDag<T>;
+    friend class ExpressionParser<T>;
+    friend class ExpressionSimplifier<T>;
+    friend class IncrementalEvaluator<T>;
+    friend class Polynomial<T>;
+    friend class ExpressionCache<T>;
+
+    typedef ExpressionArena<T> Arena;
+    typedef typename Arena::Node Node;
+
+    Expression(std::shared_ptr<Arena> arena, unsigned int id);
     Expression(char op, const Expression& lhs, const Expression& rhs);
     Expression(const std::string& func, const Expression& expr);
-    static Expression simplify(const Expression& expr);
-    static std::string trim(const std::string& str);
-    static std::string stripOuterParens(const std::string& s);
-
-    Type type;
-    T constantValue;
-    std::string variableName;
-    char operation;
-    std::shared_ptr<Expression> left;
-    std::shared_ptr<Expression> right;
+    Expression combine(char op, const Expression& rhs) &&;
+    static unsigned int combineNode(Arena& arena, char op, unsigned int l, unsigned int r);
+    static T evaluateNode(const Arena& arena, unsigned int id, const std::map<std::string, T>& values);
+    static std::string toStringNode(const Arena& arena, unsigned int id);
+    static std::shared_ptr<Arena> writableArena(const Expression& expr);
+
+    const Node& node() const;
+    Expression child(unsigned int childId) const;
+    unsigned int idIn(Arena& target) const;
+
+    std::shared_ptr<Arena> arena;
+    unsigned int id;
 };
 
 #endif
\ No newline at end of file
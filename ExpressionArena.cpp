@@ -0,0 +1,157 @@
+#include "ExpressionArena.hpp"
+#include "ExpressionStats.hpp"
+#include <complex>
+#include <stdexcept>
+#include <limits>
+
+namespace {
+
+std::atomic<uint64_t> nextSerial{1};
+
+}
+
+template <typename T>
+ExpressionArena<T>::ExpressionArena()
+    : directory(nullptr),
+      directoryCapacity(0),
+      count(0),
+      owner(std::this_thread::get_id()),
+      serial(nextSerial.fetch_add(1, std::memory_order_relaxed)),
+      tracked(0) {
+}
+
+template <typename T>
+ExpressionArena<T>::~ExpressionArena() {
+    if (tracked) ExpressionStats::nodesReleased(tracked);
+}
+
+template <typename T>
+unsigned int ExpressionArena<T>::add(const Node& node) {
+    unsigned int id = count.load(std::memory_order_relaxed);
+    if (id == std::numeric_limits<unsigned int>::max()) throw std::length_error("Expression arena is full.");
+    size_t page = id >> pageBits;
+    if ((id & (pageSize - 1)) == 0) {
+        if (page == directoryCapacity) {
+            size_t capacity = directoryCapacity ? directoryCapacity * 2 : 16;
+            std::unique_ptr<Node*[]> grown(new Node*[capacity]());
+            for (size_t i = 0; i < directoryCapacity; i++) grown[i] = directories.back()[i];
+            directories.push_back(std::move(grown));
+            directoryCapacity = capacity;
+            directory.store(directories.back().get(), std::memory_order_release);
+        }
+        pages.emplace_back(new Node[pageSize]);
+        directories.back()[page] = pages.back().get();
+    }
+    directories.back()[page][id & (pageSize - 1)] = node;
+    count.store(id + 1, std::memory_order_release);
+    if (ExpressionStats::enabled()) {
+        ExpressionStats::nodesAdded(1);
+        tracked++;
+    }
+    return id;
+}
+
+template <typename T>
+unsigned int ExpressionArena<T>::import(const ExpressionArena& source, unsigned int id) {
+    if (&source == this) return id;
+    auto keyOf = [&source](unsigned int n) { return (source.serial << 32) | n; };
+    std::vector<std::pair<unsigned int, bool>> pending{{id, false}};
+    while (!pending.empty()) {
+        auto [n, expanded] = pending.back();
+        if (imports.count(keyOf(n))) {
+            pending.pop_back();
+            continue;
+        }
+        Node copy = source.node(n);
+        bool hasChildren = copy.type == OPERATION || copy.type == FUNCTION;
+        if (hasChildren && !expanded) {
+            pending.back().second = true;
+            pending.push_back({copy.left, false});
+            if (copy.type == OPERATION) pending.push_back({copy.right, false});
+            continue;
+        }
+        pending.pop_back();
+        if (hasChildren) {
+            copy.left = imports.at(keyOf(copy.left));
+            if (copy.type == OPERATION) copy.right = imports.at(keyOf(copy.right));
+        }
+        imports.emplace(keyOf(n), add(copy));
+    }
+    return imports.at(keyOf(id));
+}
+
+template <typename T>
+void ExpressionArena<T>::releaseImports() {
+    std::unordered_map<uint64_t, unsigned int>().swap(imports);
+}
+
+template <typename T>
+bool ExpressionArena<T>::writableHere() const {
+    return owner == std::this_thread::get_id();
+}
+
+template <typename T>
+size_t ExpressionArena<T>::size() const {
+    return count.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t ExpressionArena<T>::bytes() const {
+    size_t total = pages.size() * pageSize * sizeof(Node);
+    for (size_t capacity = directoryCapacity; capacity >= 16; capacity /= 2) total += capacity * sizeof(Node*);
+    total += imports.bucket_count() * sizeof(void*) + imports.size() * (sizeof(std::pair<const uint64_t, unsigned int>) + sizeof(void*));
+    return total;
+}
+
+template <typename T>
+std::shared_ptr<ExpressionArena<T>>& ExpressionArena<T>::scoped() {
+    static thread_local std::shared_ptr<ExpressionArena> arena;
+    return arena;
+}
+
+template <typename T>
+std::weak_ptr<ExpressionArena<T>>& ExpressionArena<T>::fallback() {
+    static thread_local std::weak_ptr<ExpressionArena> arena;
+    return arena;
+}
+
+template <typename T>
+bool ExpressionArena<T>::retired() const {
+    // Imported nodes are the live operands a fresh arena had to copy in, so
+    // the budget scales with them and retiring stays linear overall.
+    return count.load(std::memory_order_relaxed) >= fallbackBudget + 2 * imports.size();
+}
+
+template <typename T>
+std::shared_ptr<ExpressionArena<T>> ExpressionArena<T>::current() {
+    if (scoped()) return scoped();
+    std::shared_ptr<ExpressionArena> arena = fallback().lock();
+    if (!arena || arena->retired()) {
+        if (arena) arena->releaseImports();
+        arena = std::make_shared<ExpressionArena>();
+        fallback() = arena;
+    }
+    return arena;
+}
+
+template <typename T>
+bool ExpressionArena<T>::isCurrent(const std::shared_ptr<ExpressionArena>& arena) {
+    if (scoped()) return scoped() == arena;
+    // Compares control blocks, so no reference count is touched on the hot path.
+    const std::weak_ptr<ExpressionArena>& f = fallback();
+    return arena && !f.owner_before(arena) && !arena.owner_before(f) && !arena->retired();
+}
+
+template <typename T>
+ExpressionArena<T>::Scope::Scope(std::shared_ptr<ExpressionArena> arena) : previous(scoped()) {
+    if (!arena || !arena->writableHere()) throw std::logic_error("Expression arena belongs to another thread.");
+    scoped() = std::move(arena);
+}
+
+template <typename T>
+ExpressionArena<T>::Scope::~Scope() {
+    scoped() = std::move(previous);
+}
+
+template class ExpressionArena<double>;
+template class ExpressionArena<std::complex<double>>;
\ No newline at end of file
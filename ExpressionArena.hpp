@@ -0,0 +1,90 @@
+#ifndef EXPRESSION_ARENA_HPP
+#define EXPRESSION_ARENA_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Node store behind Expression<T>. Nodes are appended to fixed-size pages that
+// never move, children are 32-bit indices into the same arena and variable
+// names are SymbolTable ids. New nodes always go to the current arena of the
+// calling thread: the innermost Scope, or else a thread-local fallback, and
+// operands living elsewhere are imported. Other threads may read nodes they
+// were handed at any time. Everything is freed together when the last
+// Expression referring to the arena goes away. Nodes cannot be freed one by
+// one, so the fallback is retired once it holds fallbackBudget nodes beyond
+// twice what it imported: later work starts a fresh arena and copies in only
+// the operands it still uses, and the retired arena dies with its last user.
+template <typename T>
+class ExpressionArena {
+public:
+    enum Kind : unsigned char { CONSTANT, VARIABLE, OPERATION, FUNCTION };
+    enum Function : unsigned char { SIN, COS, LN, EXP };
+
+    struct Node {
+        unsigned char type;
+        char operation;
+        unsigned char function;
+        unsigned char reserved;
+        unsigned int symbol;
+        unsigned int left;
+        unsigned int right;
+        T value;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<ExpressionArena> arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::shared_ptr<ExpressionArena> previous;
+    };
+
+    ExpressionArena();
+    ~ExpressionArena();
+    ExpressionArena(const ExpressionArena&) = delete;
+    ExpressionArena& operator=(const ExpressionArena&) = delete;
+
+    unsigned int add(const Node& node);
+    unsigned int import(const ExpressionArena& source, unsigned int id);
+    void releaseImports();
+    bool writableHere() const;
+    size_t size() const;
+    size_t bytes() const;
+
+    const Node& node(unsigned int id) const {
+        Node* const* table = directory.load(std::memory_order_acquire);
+        return table[id >> pageBits][id & (pageSize - 1)];
+    }
+
+    static std::shared_ptr<ExpressionArena> current();
+    static bool isCurrent(const std::shared_ptr<ExpressionArena>& arena);
+
+private:
+    static constexpr unsigned int pageBits = 8;
+    static constexpr unsigned int pageSize = 1u << pageBits;
+    static constexpr unsigned int fallbackBudget = 1u << 16;
+
+    static std::shared_ptr<ExpressionArena>& scoped();
+    static std::weak_ptr<ExpressionArena>& fallback();
+
+    bool retired() const;
+
+    std::atomic<Node**> directory;
+    size_t directoryCapacity;
+    std::vector<std::unique_ptr<Node*[]>> directories;
+    std::vector<std::unique_ptr<Node[]>> pages;
+    std::atomic<unsigned int> count;
+    std::thread::id owner;
+    uint64_t serial;
+    uint64_t tracked;
+    std::unordered_map<uint64_t, unsigned int> imports;
+};
+
+#endif
\ No newline at end of file
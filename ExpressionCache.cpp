@@ -0,0 +1,139 @@
+#include "ExpressionCache.hpp"
+#include <cctype>
+
+template <typename T>
+ExpressionCache<T>::ExpressionCache(size_t capacityBytes)
+    : capacityBytes(capacityBytes),
+      usedBytes(0),
+      hits(0),
+      misses(0),
+      evictions(0) {
+}
+
+template <typename T>
+std::string ExpressionCache<T>::normalize(std::string_view text) {
+    auto isWord = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.'; };
+    std::string result;
+    result.reserve(text.size());
+    bool gap = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            gap = true;
+            continue;
+        }
+        if (gap && !result.empty() && isWord(result.back()) && isWord(c)) result += ' ';
+        result += c;
+        gap = false;
+    }
+    return result;
+}
+
+template <typename T>
+std::shared_ptr<const typename ExpressionCache<T>::Entry> ExpressionCache<T>::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    items.splice(items.begin(), items, it->second);
+    return it->second->entry;
+}
+
+template <typename T>
+std::shared_ptr<const typename ExpressionCache<T>::Entry> ExpressionCache<T>::insert(const std::string& key, std::shared_ptr<const Entry> entry,
+                                                                                     bool replace) {
+    size_t bytes = footprint(key, *entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        items.splice(items.begin(), items, it->second);
+        if (!replace) return it->second->entry;
+        usedBytes = usedBytes - it->second->bytes + bytes;
+        it->second->entry = entry;
+        it->second->bytes = bytes;
+    } else {
+        items.push_front({key, entry, bytes});
+        index.emplace(key, items.begin());
+        usedBytes += bytes;
+    }
+    while (usedBytes > capacityBytes && !items.empty()) {
+        usedBytes -= items.back().bytes;
+        index.erase(items.back().key);
+        items.pop_back();
+        evictions++;
+    }
+    return entry;
+}
+
+template <typename T>
+size_t ExpressionCache<T>::footprint(const std::string& key, const Entry& entry) {
+    size_t bytes = sizeof(Item) + sizeof(Entry) + 2 * key.size() + entry.expr.arena->bytes();
+    if (entry.compiled) bytes += entry.compiled->bytes();
+    return bytes;
+}
+
+// Builds in a scratch arena, then copies just the result into a fresh one,
+// dropping intermediate nodes and any nodes shared with other entries.
+template <typename T>
+template <typename Build>
+Expression<T> ExpressionCache<T>::isolate(Build build) {
+    typedef ExpressionArena<T> Arena;
+    std::shared_ptr<Arena> scratch = std::make_shared<Arena>();
+    Expression<T> built = [&build, &scratch]() {
+        typename Arena::Scope scope(scratch);
+        return build();
+    }();
+    std::shared_ptr<Arena> owned = std::make_shared<Arena>();
+    unsigned int root = owned->import(*built.arena, built.id);
+    owned->releaseImports();
+    return Expression<T>(std::move(owned), root);
+}
+
+template <typename T>
+std::shared_ptr<const typename ExpressionCache<T>::Entry> ExpressionCache<T>::parse(std::string_view text) {
+    std::string key = normalize(text);
+    if (std::shared_ptr<const Entry> entry = find(key)) return entry;
+    Expression<T> expr = isolate([text]() { return Expression<T>::fromString(text); });
+    return insert(key, std::make_shared<const Entry>(Entry{std::move(expr), nullptr}), false);
+}
+
+template <typename T>
+std::shared_ptr<const typename ExpressionCache<T>::Entry> ExpressionCache<T>::derivative(std::string_view text, const std::string& var) {
+    std::string key = normalize(text) + '\0' + var;
+    if (std::shared_ptr<const Entry> entry = find(key)) return entry;
+    std::shared_ptr<const Entry> base = parse(text);
+    Expression<T> expr = isolate([&base, &var]() { return base->expr.differentiate(var); });
+    return insert(key, std::make_shared<const Entry>(Entry{std::move(expr), nullptr}), false);
+}
+
+template <typename T>
+std::shared_ptr<const typename ExpressionCache<T>::Entry> ExpressionCache<T>::compile(std::string_view text) {
+    std::shared_ptr<const Entry> entry = parse(text);
+    if (entry->compiled) return entry;
+    std::shared_ptr<const CompiledExpression<T>> compiled = std::make_shared<const CompiledExpression<T>>(entry->expr);
+    return insert(normalize(text), std::make_shared<const Entry>(Entry{entry->expr, compiled}), true);
+}
+
+template <typename T>
+typename ExpressionCache<T>::Counters ExpressionCache<T>::counters() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {hits, misses, evictions, items.size(), usedBytes};
+}
+
+template <typename T>
+size_t ExpressionCache<T>::capacity() const {
+    return capacityBytes;
+}
+
+template <typename T>
+void ExpressionCache<T>::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    items.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+template class ExpressionCache<double>;
+template class ExpressionCache<std::complex<double>>;
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef EXPRESSION_CACHE_HPP
+#define EXPRESSION_CACHE_HPP
+
+#include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// LRU cache of parsed, differentiated and compiled expressions bounded by
+// bytes. Each entry keeps its nodes in an arena of its own, so evicting it
+// gives the memory back, and compiled entries may be evaluated concurrently.
+template <typename T>
+class ExpressionCache {
+public:
+    struct Entry {
+        Expression<T> expr;
+        std::shared_ptr<const CompiledExpression<T>> compiled;
+    };
+
+    struct Counters {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t entries;
+        size_t bytes;
+    };
+
+    explicit ExpressionCache(size_t capacityBytes);
+
+    std::shared_ptr<const Entry> parse(std::string_view text);
+    std::shared_ptr<const Entry> derivative(std::string_view text, const std::string& var);
+    std::shared_ptr<const Entry> compile(std::string_view text);
+
+    Counters counters() const;
+    size_t capacity() const;
+    void clear();
+
+    static std::string normalize(std::string_view text);
+
+private:
+    struct Item {
+        std::string key;
+        std::shared_ptr<const Entry> entry;
+        size_t bytes;
+    };
+
+    std::shared_ptr<const Entry> find(const std::string& key);
+    std::shared_ptr<const Entry> insert(const std::string& key, std::shared_ptr<const Entry> entry, bool replace);
+    static size_t footprint(const std::string& key, const Entry& entry);
+    template <typename Build>
+    static Expression<T> isolate(Build build);
+
+    mutable std::mutex mutex;
+    std::list<Item> items;
+    std::unordered_map<std::string, typename std::list<Item>::iterator> index;
+    size_t capacityBytes;
+    size_t usedBytes;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+};
+
+#endif
\ No newline at end of file
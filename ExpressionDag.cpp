@@ -0,0 +1,324 @@
+#include "ExpressionDag.hpp"
+#include "ExpressionMath.hpp"
+#include "SymbolTable.hpp"
+#include <cstring>
+
+template <typename T>
+bool ExpressionDag<T>::Key::operator==(const Key& other) const {
+    return kind == other.kind && left == other.left && right == other.right
+        && bits[0] == other.bits[0] && bits[1] == other.bits[1];
+}
+
+template <typename T>
+size_t ExpressionDag<T>::KeyHash::operator()(const Key& key) const {
+    uint64_t h = key.kind;
+    h = h * 0x9e3779b97f4a7c15ULL ^ key.left;
+    h = h * 0x9e3779b97f4a7c15ULL ^ key.right;
+    h = h * 0x9e3779b97f4a7c15ULL ^ key.bits[0];
+    h = h * 0x9e3779b97f4a7c15ULL ^ key.bits[1];
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::intern(Kind kind, NodeId lhs, NodeId rhs, T value) {
+    static_assert(sizeof(T) <= sizeof(Key::bits), "constant does not fit the hash key");
+    Key key{kind, lhs, rhs, {0, 0}};
+    if (kind == CONSTANT) std::memcpy(key.bits, &value, sizeof(T));
+    auto it = table.find(key);
+    if (it != table.end()) return it->second;
+    NodeId id = static_cast<NodeId>(nodes.size());
+    nodes.push_back({kind, lhs, rhs, value});
+    table.emplace(key, id);
+    return id;
+}
+
+template <typename T>
+bool ExpressionDag<T>::isConstant(NodeId id, T value) const {
+    return nodes[id].kind == CONSTANT && nodes[id].value == value;
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::constant(T value) {
+    return intern(CONSTANT, 0, 0, value);
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::variable(const std::string& name) {
+    auto it = nameIndex.find(name);
+    NodeId index;
+    if (it != nameIndex.end()) {
+        index = it->second;
+    } else {
+        index = static_cast<NodeId>(names.size());
+        names.push_back(name);
+        nameIndex.emplace(name, index);
+    }
+    return intern(VARIABLE, index, 0, T(0));
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::operation(char op, NodeId lhs, NodeId rhs) {
+    switch (op) {
+    case '+':
+        if (isConstant(lhs, T(0))) return rhs;
+        if (isConstant(rhs, T(0))) return lhs;
+        return intern(ADD, lhs, rhs, T(0));
+    case '-':
+        if (isConstant(rhs, T(0))) return lhs;
+        return intern(SUB, lhs, rhs, T(0));
+    case '*':
+        if (isConstant(lhs, T(0)) || isConstant(rhs, T(0))) return constant(T(0));
+        if (isConstant(lhs, T(1))) return rhs;
+        if (isConstant(rhs, T(1))) return lhs;
+        return intern(MUL, lhs, rhs, T(0));
+    case '/':
+        if (isConstant(lhs, T(0))) return constant(T(0));
+        if (isConstant(rhs, T(1))) return lhs;
+        return intern(DIV, lhs, rhs, T(0));
+    case '^':
+        if (isConstant(rhs, T(0))) return constant(T(1));
+        if (isConstant(rhs, T(1))) return lhs;
+        return intern(POW, lhs, rhs, T(0));
+    default:
+        throw std::runtime_error("Unknown operation");
+    }
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::function(const std::string& func, NodeId arg) {
+    if (func == "sin") return intern(SIN, arg, 0, T(0));
+    if (func == "cos") return intern(COS, arg, 0, T(0));
+    if (func == "ln") return intern(LN, arg, 0, T(0));
+    if (func == "exp") return intern(EXP, arg, 0, T(0));
+    throw std::runtime_error("Unknown function");
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::fromExpression(const Expression<T>& expr) {
+    std::unordered_map<unsigned int, NodeId> seen;
+    return fromExpression(*expr.arena, expr.id, seen);
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::fromExpression(const ExpressionArena<T>& arena, unsigned int id,
+                                                                   std::unordered_map<unsigned int, NodeId>& seen) {
+    typedef ExpressionArena<T> Arena;
+    std::vector<std::pair<unsigned int, bool>> pending{{id, false}};
+    while (!pending.empty()) {
+        auto [current, expanded] = pending.back();
+        if (seen.count(current)) {
+            pending.pop_back();
+            continue;
+        }
+        const typename Arena::Node& n = arena.node(current);
+        bool hasChildren = n.type == Arena::OPERATION || n.type == Arena::FUNCTION;
+        if (hasChildren && !expanded) {
+            pending.back().second = true;
+            if (n.type == Arena::OPERATION) pending.push_back({n.right, false});
+            pending.push_back({n.left, false});
+            continue;
+        }
+        pending.pop_back();
+        NodeId result;
+        switch (n.type) {
+        case Arena::CONSTANT:
+            result = constant(n.value);
+            break;
+        case Arena::VARIABLE:
+            result = variable(SymbolTable::name(n.symbol));
+            break;
+        case Arena::FUNCTION:
+            result = intern(static_cast<Kind>(SIN + n.function), seen.at(n.left), 0, T(0));
+            break;
+        default:
+            result = operation(n.operation, seen.at(n.left), seen.at(n.right));
+            break;
+        }
+        seen.emplace(current, result);
+    }
+    return seen.at(id);
+}
+
+template <typename T>
+std::vector<char> ExpressionDag<T>::mark(const std::vector<NodeId>& roots) const {
+    NodeId top = 0;
+    for (NodeId root : roots) top = std::max(top, root);
+    std::vector<char> marked(roots.empty() ? 0 : top + 1, 0);
+    for (NodeId root : roots) marked[root] = 1;
+    for (size_t i = marked.size(); i-- > 0;) {
+        if (!marked[i]) continue;
+        const Node& n = nodes[i];
+        if (n.kind == CONSTANT || n.kind == VARIABLE) continue;
+        marked[n.left] = 1;
+        if (n.kind <= POW) marked[n.right] = 1;
+    }
+    return marked;
+}
+
+template <typename T>
+Expression<T> ExpressionDag<T>::toExpression(NodeId id) const {
+    typedef ExpressionArena<T> Arena;
+    static const char ops[] = {'+', '-', '*', '/', '^'};
+    std::vector<char> marked = mark({id});
+    std::vector<unsigned int> built(marked.size());
+    std::vector<unsigned int> symbols(names.size());
+    for (size_t i = 0; i < names.size(); i++) symbols[i] = SymbolTable::intern(names[i]);
+    std::shared_ptr<Arena> arena = Arena::current();
+    for (size_t i = 0; i < marked.size(); i++) {
+        if (!marked[i]) continue;
+        const Node& n = nodes[i];
+        switch (n.kind) {
+        case CONSTANT:
+            built[i] = arena->add({Arena::CONSTANT, '\0', 0, 0, 0, 0, 0, n.value});
+            break;
+        case VARIABLE:
+            built[i] = arena->add({Arena::VARIABLE, '\0', 0, 0, symbols[n.left], 0, 0, T(0)});
+            break;
+        case SIN: case COS: case LN: case EXP:
+            built[i] = arena->add({Arena::FUNCTION, '\0', static_cast<unsigned char>(n.kind - SIN), 0, 0, built[n.left], 0, T(0)});
+            break;
+        default:
+            built[i] = arena->add({Arena::OPERATION, ops[n.kind - ADD], 0, 0, 0, built[n.left], built[n.right], T(0)});
+            break;
+        }
+    }
+    return Expression<T>(arena, built[id]);
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::differentiate(NodeId id, const std::string& var) {
+    auto it = nameIndex.find(var);
+    if (it == nameIndex.end()) return constant(T(0));
+    return differentiate(id, it->second);
+}
+
+template <typename T>
+typename ExpressionDag<T>::NodeId ExpressionDag<T>::differentiate(NodeId id, NodeId var) {
+    auto keyOf = [var](NodeId n) { return (static_cast<uint64_t>(n) << 32) | var; };
+    auto d = [this, &keyOf](NodeId n) { return derivatives.at(keyOf(n)); };
+    std::vector<std::pair<NodeId, bool>> pending{{id, false}};
+    while (!pending.empty()) {
+        auto [current, expanded] = pending.back();
+        if (derivatives.count(keyOf(current))) {
+            pending.pop_back();
+            continue;
+        }
+        Node n = nodes[current];
+        bool hasChildren = n.kind != CONSTANT && n.kind != VARIABLE;
+        if (hasChildren && !expanded) {
+            pending.back().second = true;
+            if (n.kind <= POW) pending.push_back({n.right, false});
+            pending.push_back({n.left, false});
+            continue;
+        }
+        pending.pop_back();
+        NodeId result;
+        switch (n.kind) {
+        case CONSTANT:
+            result = constant(T(0));
+            break;
+        case VARIABLE:
+            result = constant(n.left == var ? T(1) : T(0));
+            break;
+        case SIN:
+            result = operation('*', function("cos", n.left), d(n.left));
+            break;
+        case COS:
+            result = operation('*', operation('*', constant(T(-1)), function("sin", n.left)), d(n.left));
+            break;
+        case LN:
+            result = operation('*', operation('/', constant(T(1)), n.left), d(n.left));
+            break;
+        case EXP:
+            result = operation('*', current, d(n.left));
+            break;
+        case ADD:
+            result = operation('+', d(n.left), d(n.right));
+            break;
+        case SUB:
+            result = operation('-', d(n.left), d(n.right));
+            break;
+        case MUL:
+            result = operation('+', operation('*', d(n.left), n.right), operation('*', n.left, d(n.right)));
+            break;
+        case DIV: {
+            NodeId numerator = operation('-', operation('*', d(n.left), n.right), operation('*', n.left, d(n.right)));
+            result = operation('/', numerator, operation('*', n.right, n.right));
+            break;
+        }
+        case POW:
+            if (nodes[n.right].kind == CONSTANT) {
+                NodeId power = operation('^', n.left, constant(nodes[n.right].value - T(1)));
+                result = operation('*', operation('*', n.right, power), d(n.left));
+            } else {
+                NodeId lnF = function("ln", n.left);
+                NodeId base = function("exp", operation('*', n.right, lnF));
+                NodeId chain = operation('+', operation('*', d(n.right), lnF),
+                                         operation('/', operation('*', n.right, d(n.left)), n.left));
+                result = operation('*', base, chain);
+            }
+            break;
+        default:
+            throw std::runtime_error("Unknown operation in differentiation");
+        }
+        derivatives.emplace(keyOf(current), result);
+    }
+    return d(id);
+}
+
+template <typename T>
+T ExpressionDag<T>::evaluate(NodeId root, const std::map<std::string, T>& values) const {
+    return evaluate(std::vector<NodeId>{root}, values)[0];
+}
+
+template <typename T>
+std::vector<T> ExpressionDag<T>::evaluate(const std::vector<NodeId>& roots, const std::map<std::string, T>& values) const {
+    std::vector<char> marked = mark(roots);
+    std::vector<T> results(marked.size());
+    for (size_t i = 0; i < marked.size(); i++) {
+        if (!marked[i]) continue;
+        const Node& n = nodes[i];
+        switch (n.kind) {
+        case CONSTANT: results[i] = n.value; break;
+        case VARIABLE: results[i] = values.at(names[n.left]); break;
+        case ADD: results[i] = results[n.left] + results[n.right]; break;
+        case SUB: results[i] = results[n.left] - results[n.right]; break;
+        case MUL: results[i] = results[n.left] * results[n.right]; break;
+        case DIV: results[i] = expressionDivide(results[n.left], results[n.right]); break;
+        case POW: results[i] = std::pow(results[n.left], results[n.right]); break;
+        case SIN: results[i] = std::sin(results[n.left]); break;
+        case COS: results[i] = std::cos(results[n.left]); break;
+        case LN: results[i] = expressionLog(results[n.left]); break;
+        case EXP: results[i] = std::exp(results[n.left]); break;
+        }
+    }
+    std::vector<T> out;
+    out.reserve(roots.size());
+    for (NodeId root : roots) out.push_back(results[root]);
+    return out;
+}
+
+template <typename T>
+const typename ExpressionDag<T>::Node& ExpressionDag<T>::node(NodeId id) const {
+    return nodes.at(id);
+}
+
+template <typename T>
+const std::string& ExpressionDag<T>::variableName(NodeId id) const {
+    if (nodes.at(id).kind != VARIABLE) throw std::invalid_argument("Node is not a variable.");
+    return names[nodes[id].left];
+}
+
+template <typename T>
+size_t ExpressionDag<T>::size() const {
+    return nodes.size();
+}
+
+template <typename T>
+size_t ExpressionDag<T>::reachable(const std::vector<NodeId>& roots) const {
+    std::vector<char> marked = mark(roots);
+    return static_cast<size_t>(std::count(marked.begin(), marked.end(), 1));
+}
+
+template class ExpressionDag<double>;
+template class ExpressionDag<std::complex<double>>;
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef EXPRESSION_DAG_HPP
+#define EXPRESSION_DAG_HPP
+
+#include "Expression.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+template <typename T>
+class ExpressionDag {
+public:
+    typedef unsigned int NodeId;
+    enum Kind : unsigned char { CONSTANT, VARIABLE, ADD, SUB, MUL, DIV, POW, SIN, COS, LN, EXP };
+
+    struct Node {
+        Kind kind;
+        NodeId left;
+        NodeId right;
+        T value;
+    };
+
+    NodeId constant(T value);
+    NodeId variable(const std::string& name);
+    NodeId operation(char op, NodeId lhs, NodeId rhs);
+    NodeId function(const std::string& func, NodeId arg);
+
+    NodeId fromExpression(const Expression<T>& expr);
+    Expression<T> toExpression(NodeId id) const;
+    NodeId differentiate(NodeId id, const std::string& var);
+
+    T evaluate(NodeId root, const std::map<std::string, T>& values) const;
+    std::vector<T> evaluate(const std::vector<NodeId>& roots, const std::map<std::string, T>& values) const;
+
+    const Node& node(NodeId id) const;
+    const std::string& variableName(NodeId id) const;
+    size_t size() const;
+    size_t reachable(const std::vector<NodeId>& roots) const;
+
+private:
+    struct Key {
+        Kind kind;
+        NodeId left;
+        NodeId right;
+        uint64_t bits[2];
+        bool operator==(const Key& other) const;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    NodeId intern(Kind kind, NodeId lhs, NodeId rhs, T value);
+    NodeId fromExpression(const ExpressionArena<T>& arena, unsigned int id, std::unordered_map<unsigned int, NodeId>& seen);
+    NodeId differentiate(NodeId id, NodeId var);
+    bool isConstant(NodeId id, T value) const;
+    std::vector<char> mark(const std::vector<NodeId>& roots) const;
+
+    std::vector<Node> nodes;
+    std::unordered_map<Key, NodeId, KeyHash> table;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, NodeId> nameIndex;
+    std::unordered_map<uint64_t, NodeId> derivatives;
+};
+
+#endif
\ No newline at end of file
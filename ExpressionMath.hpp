@@ -0,0 +1,72 @@
+#ifndef EXPRESSION_MATH_HPP
+#define EXPRESSION_MATH_HPP
+
+#include <iostream>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// Status flags raised by checked evaluation, one byte per point, in the
+// spirit of the IEEE 754 exception flags.
+enum DomainFlag : unsigned char {
+    DIVISION_BY_ZERO = 1,
+    LOG_DOMAIN = 2,
+    NOT_FINITE = 4
+};
+
+// Real division by zero is the IEEE quotient on every path (+-inf, or NaN
+// for 0/0); complex division by zero throws unless a status is supplied.
+template <typename T>
+T expressionDivide(T leftVal, T rightVal) {
+    if constexpr (!std::is_floating_point_v<T>) {
+        if (rightVal == T(0)) throw std::runtime_error("Division by zero for complex.");
+    }
+    return leftVal / rightVal;
+}
+
+template <typename T>
+T expressionLog(T val) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (val <= T(0)) {
+            std::cerr << "Warning: Logarithm of zero or negative number is undefined. Returning -inf.\n";
+            return -std::numeric_limits<T>::infinity();
+        }
+    }
+    return std::log(val);
+}
+
+// Checked forms for batch evaluation: no message and no exception, the
+// problem is raised in status and an IEEE-style result is returned.
+template <typename T>
+T expressionDivide(T leftVal, T rightVal, unsigned char& status) {
+    if (rightVal == T(0)) {
+        status |= DIVISION_BY_ZERO;
+        if constexpr (!std::is_floating_point_v<T>) {
+            return T(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+    return leftVal / rightVal;
+}
+
+template <typename T>
+T expressionLog(T val, unsigned char& status) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (val <= T(0)) {
+            status |= LOG_DOMAIN;
+            return -std::numeric_limits<T>::infinity();
+        }
+    } else {
+        if (val == T(0)) status |= LOG_DOMAIN;
+    }
+    return std::log(val);
+}
+
+template <typename T>
+bool expressionFinite(T val) {
+    if constexpr (std::is_floating_point_v<T>) return std::isfinite(val);
+    else return std::isfinite(val.real()) && std::isfinite(val.imag());
+}
+
+#endif
\ No newline at end of file
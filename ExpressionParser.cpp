@@ -0,0 +1,207 @@
+#include "ExpressionParser.hpp"
+#include <cctype>
+#include <cstdlib>
+
+ParseError::ParseError(const std::string& message, size_t position)
+    : std::runtime_error("Invalid expression at position " + std::to_string(position) + ": " + message),
+      offset(position) {
+}
+
+size_t ParseError::position() const {
+    return offset;
+}
+
+template <typename T>
+ExpressionParser<T>::ExpressionParser(std::string_view text)
+    : input(text), cursor(0), token{END, std::string_view(), 0, 0.0} {
+}
+
+// Shunting-yard over an explicit operator stack, so nesting depth is bounded
+// by the heap rather than the call stack. Prefix minus binds tighter than '*'
+// and '/' but looser than '^', which keeps -x^2 == -(x^2) and a^-b^c ==
+// a^(-(b^c)).
+template <typename T>
+Expression<T> ExpressionParser<T>::parse() {
+    advance();
+    if (token.kind == END) fail("expected an expression", token.position);
+
+    std::vector<Expression<T>> operands;
+    std::vector<Pending> operators;
+    auto isGroup = [](const Pending& p) { return p.op == '(' || p.op == 'f'; };
+    auto innermost = [&]() -> const Pending* {
+        for (size_t i = operators.size(); i-- > 0;) {
+            if (isGroup(operators[i])) return &operators[i];
+        }
+        return nullptr;
+    };
+
+    bool expectOperand = true;
+    for (;;) {
+        if (expectOperand) {
+            if (token.kind == NUMBER) {
+                operands.push_back(Expression<T>(T(token.number)));
+                expectOperand = false;
+                advance();
+            } else if (token.kind == IDENTIFIER) {
+                Token name = token;
+                advance();
+                if (token.kind != LPAREN) {
+                    operands.push_back(Expression<T>(std::string(name.text)));
+                    expectOperand = false;
+                    continue;
+                }
+                if (name.text != "sin" && name.text != "cos" && name.text != "ln" && name.text != "exp") {
+                    fail("unknown function '" + std::string(name.text) + "'", name.position);
+                }
+                operators.push_back({'f', token.position, name.text});
+                advance();
+            } else if (token.kind == LPAREN) {
+                operators.push_back({'(', token.position, std::string_view()});
+                advance();
+            } else if (token.kind == OPERATOR && (token.text[0] == '-' || token.text[0] == '+')) {
+                if (token.text[0] == '-') {
+                    if (!operators.empty() && operators.back().op == '~') operators.pop_back();
+                    else operators.push_back({'~', token.position, std::string_view()});
+                }
+                advance();
+            } else {
+                fail("expected a number, variable or '(', found " + describe(token), token.position);
+            }
+            continue;
+        }
+
+        if (int prec = precedence(token)) {
+            char op = token.text[0];
+            while (!operators.empty() && !isGroup(operators.back())) {
+                int top = binding(operators.back().op);
+                if (top < prec || (top == prec && op == '^')) break;
+                reduce(operands, operators.back());
+                operators.pop_back();
+            }
+            operators.push_back({op, token.position, std::string_view()});
+            expectOperand = true;
+            advance();
+            continue;
+        }
+
+        const Pending* open = innermost();
+        if (token.kind == RPAREN && open) {
+            while (!isGroup(operators.back())) {
+                reduce(operands, operators.back());
+                operators.pop_back();
+            }
+            reduce(operands, operators.back());
+            operators.pop_back();
+            advance();
+            continue;
+        }
+        if (open) fail("expected ')' to close '(' at position " + std::to_string(open->position) + ", found " + describe(token), token.position);
+        if (token.kind != END) fail("unexpected " + describe(token), token.position);
+        break;
+    }
+
+    while (!operators.empty()) {
+        reduce(operands, operators.back());
+        operators.pop_back();
+    }
+    return operands.back();
+}
+
+template <typename T>
+void ExpressionParser<T>::reduce(std::vector<Expression<T>>& operands, const Pending& pending) const {
+    if (pending.op == '(') return;
+    Expression<T> top = operands.back();
+    operands.pop_back();
+    if (pending.op == '~') {
+        operands.push_back(negate(top));
+    } else if (pending.op == 'f') {
+        operands.push_back(Expression<T>(std::string(pending.name), top));
+    } else {
+        operands.back() = Expression<T>(pending.op, operands.back(), top);
+    }
+}
+
+template <typename T>
+void ExpressionParser<T>::advance() {
+    while (cursor < input.size() && std::isspace(static_cast<unsigned char>(input[cursor]))) cursor++;
+    size_t start = cursor;
+    if (cursor == input.size()) {
+        token = {END, std::string_view(), start, 0.0};
+        return;
+    }
+    auto isDigit = [this](size_t i) { return i < input.size() && std::isdigit(static_cast<unsigned char>(input[i])); };
+    char c = input[cursor];
+    if (isDigit(cursor) || (c == '.' && isDigit(cursor + 1))) {
+        while (isDigit(cursor)) cursor++;
+        if (cursor < input.size() && input[cursor] == '.') {
+            cursor++;
+            while (isDigit(cursor)) cursor++;
+        }
+        if (cursor < input.size() && (input[cursor] == 'e' || input[cursor] == 'E')) {
+            size_t exponent = cursor + 1;
+            if (exponent < input.size() && (input[exponent] == '+' || input[exponent] == '-')) exponent++;
+            if (isDigit(exponent)) {
+                cursor = exponent;
+                while (isDigit(cursor)) cursor++;
+            }
+        }
+        std::string_view text = input.substr(start, cursor - start);
+        token = {NUMBER, text, start, std::strtod(std::string(text).c_str(), nullptr)};
+        return;
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+        while (cursor < input.size() && (std::isalnum(static_cast<unsigned char>(input[cursor])) || input[cursor] == '_')) cursor++;
+        token = {IDENTIFIER, input.substr(start, cursor - start), start, 0.0};
+        return;
+    }
+    cursor++;
+    switch (c) {
+    case '+': case '-': case '*': case '/': case '^':
+        token = {OPERATOR, input.substr(start, 1), start, 0.0};
+        return;
+    case '(':
+        token = {LPAREN, input.substr(start, 1), start, 0.0};
+        return;
+    case ')':
+        token = {RPAREN, input.substr(start, 1), start, 0.0};
+        return;
+    default:
+        fail("unexpected character '" + std::string(1, c) + "'", start);
+    }
+}
+
+template <typename T>
+int ExpressionParser<T>::precedence(const Token& token) {
+    return token.kind == OPERATOR ? binding(token.text[0]) : 0;
+}
+
+template <typename T>
+int ExpressionParser<T>::binding(char op) {
+    switch (op) {
+    case '+': case '-': return 1;
+    case '*': case '/': return 2;
+    case '~': return 3;
+    case '^': return 4;
+    default: return 0;
+    }
+}
+
+template <typename T>
+Expression<T> ExpressionParser<T>::negate(const Expression<T>& expr) const {
+    if (expr.node().type == Expression<T>::CONSTANT) return Expression<T>(-expr.node().value);
+    return Expression<T>('*', Expression<T>(T(-1)), expr);
+}
+
+template <typename T>
+void ExpressionParser<T>::fail(const std::string& message, size_t position) const {
+    throw ParseError(message, position);
+}
+
+template <typename T>
+std::string ExpressionParser<T>::describe(const Token& token) const {
+    if (token.kind == END) return "end of input";
+    return "'" + std::string(token.text) + "'";
+}
+
+template class ExpressionParser<double>;
+template class ExpressionParser<std::complex<double>>;
\ No newline at end of file
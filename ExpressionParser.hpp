@@ -0,0 +1,54 @@
+#ifndef EXPRESSION_PARSER_HPP
+#define EXPRESSION_PARSER_HPP
+
+#include "Expression.hpp"
+#include <string_view>
+#include <vector>
+
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& message, size_t position);
+    size_t position() const;
+
+private:
+    size_t offset;
+};
+
+template <typename T>
+class ExpressionParser {
+public:
+    explicit ExpressionParser(std::string_view text);
+    Expression<T> parse();
+
+private:
+    enum TokenKind { END, NUMBER, IDENTIFIER, OPERATOR, LPAREN, RPAREN };
+
+    struct Token {
+        TokenKind kind;
+        std::string_view text;
+        size_t position;
+        double number;
+    };
+
+    // An operator waiting on the explicit stack: a binary operator, a prefix
+    // minus ('~'), an open parenthesis ('(') or a function call ('f').
+    struct Pending {
+        char op;
+        size_t position;
+        std::string_view name;
+    };
+
+    void advance();
+    void reduce(std::vector<Expression<T>>& operands, const Pending& pending) const;
+    Expression<T> negate(const Expression<T>& expr) const;
+    static int precedence(const Token& token);
+    static int binding(char op);
+    [[noreturn]] void fail(const std::string& message, size_t position) const;
+    std::string describe(const Token& token) const;
+
+    std::string_view input;
+    size_t cursor;
+    Token token;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "ExpressionServer.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) return std::string_view();
+    return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
+
+bool writeAll(int fd, const std::string& data) {
+    for (size_t written = 0; written < data.size();) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+}
+
+ExpressionServer::ExpressionServer(size_t cacheBytes) : expressions(cacheBytes) {
+}
+
+std::string ExpressionServer::respond(std::string_view request) {
+    // Whatever a request builds outside the cache is freed when it returns.
+    ExpressionArena<double>::Scope scope(std::make_shared<ExpressionArena<double>>());
+    try {
+        request = trim(request);
+        size_t split = request.find_first_of(" \t");
+        std::string_view command = request.substr(0, split);
+        std::string_view rest = split == std::string_view::npos ? std::string_view() : trim(request.substr(split));
+
+        if (command == "eval") {
+            std::map<std::string, double> values;
+            for (;;) {
+                size_t space = rest.find_last_of(" \t");
+                std::string_view assignment = space == std::string_view::npos ? rest : rest.substr(space + 1);
+                size_t eqPos = assignment.find('=');
+                if (eqPos == std::string_view::npos) break;
+                values[std::string(assignment.substr(0, eqPos))] = std::stod(std::string(assignment.substr(eqPos + 1)));
+                rest = space == std::string_view::npos ? std::string_view() : trim(rest.substr(0, space));
+            }
+            std::ostringstream out;
+            out << expressions.compile(rest)->compiled->evaluate(values);
+            return out.str();
+        }
+        if (command == "diff") {
+            size_t by = rest.rfind(" by ");
+            if (by == std::string_view::npos) throw std::invalid_argument("Expected 'diff <expression> by <variable>'.");
+            std::string var(trim(rest.substr(by + 4)));
+            return expressions.derivative(rest.substr(0, by), var)->expr.toString();
+        }
+        throw std::invalid_argument("Unknown request '" + std::string(command) + "'.");
+    } catch (const std::exception& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+bool ExpressionServer::pump(int in, int out, std::string& partial) {
+    char buffer[1 << 16];
+    ssize_t n = read(in, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) return true;
+    if (n <= 0) {
+        if (!trim(partial).empty()) writeAll(out, respond(partial) + "\n");
+        return false;
+    }
+    partial.append(buffer, static_cast<size_t>(n));
+
+    std::string replies;
+    size_t start = 0;
+    for (size_t end; (end = partial.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::string_view line(partial.data() + start, end - start);
+        if (!trim(line).empty()) replies += respond(line) + "\n";
+    }
+    partial.erase(0, start);
+    return writeAll(out, replies);
+}
+
+void ExpressionServer::serve(int in, int out) {
+    std::string partial;
+    while (pump(in, out, partial)) {
+    }
+}
+
+void ExpressionServer::listen(const std::string& socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) throw std::invalid_argument("Socket path is too long.");
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) throw std::runtime_error(std::string("Cannot create socket: ") + std::strerror(errno));
+    unlink(socketPath.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0) {
+        int error = errno;
+        close(listener);
+        throw std::runtime_error("Cannot listen on " + socketPath + ": " + std::strerror(error));
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<pollfd> fds{{listener, POLLIN, 0}};
+    std::vector<std::string> partials(1);
+    for (;;) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("poll failed: ") + std::strerror(errno));
+        }
+        for (size_t i = fds.size(); i-- > 1;) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!pump(fds[i].fd, fds[i].fd, partials[i])) {
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+                partials.erase(partials.begin() + i);
+            }
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client >= 0) {
+                fds.push_back({client, POLLIN, 0});
+                partials.emplace_back();
+            }
+        }
+    }
+}
+
+const ExpressionCache<double>& ExpressionServer::cache() const {
+    return expressions;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef EXPRESSION_SERVER_HPP
+#define EXPRESSION_SERVER_HPP
+
+#include "Expression.hpp"
+#include "ExpressionCache.hpp"
+#include <string>
+#include <string_view>
+
+class ExpressionServer {
+public:
+    explicit ExpressionServer(size_t cacheBytes = 64 << 20);
+
+    std::string respond(std::string_view request);
+    void serve(int in, int out);
+    void listen(const std::string& socketPath);
+    const ExpressionCache<double>& cache() const;
+
+private:
+    bool pump(int in, int out, std::string& partial);
+
+    ExpressionCache<double> expressions;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,376 @@
+#include "ExpressionSimplifier.hpp"
+#include "SymbolTable.hpp"
+#include <cstring>
+
+namespace {
+
+template <typename T>
+bool isNegative(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return value < T(0);
+    } else {
+        return false;
+    }
+}
+
+template <typename T>
+bool isSmallInteger(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return value == std::floor(value) && std::abs(value) <= 1024.0;
+    } else {
+        return value.imag() == 0.0 && isSmallInteger(value.real());
+    }
+}
+
+template <typename T>
+int compareValue(T a, T b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (a < b) return -1;
+        if (b < a) return 1;
+        return std::memcmp(&a, &b, sizeof(T));
+    } else {
+        int c = compareValue(a.real(), b.real());
+        return c ? c : compareValue(a.imag(), b.imag());
+    }
+}
+
+template <typename V>
+void appendBytes(std::string& key, const V& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(V));
+}
+
+}
+
+template <typename T>
+ExpressionSimplifier<T>::ExpressionSimplifier(size_t budget) : budget(budget), allowance(0), counters{0, 0, 0, false} {
+}
+
+template <typename T>
+Expression<T> ExpressionSimplifier<T>::simplify(const Expression<T>& expr) {
+    terms.clear();
+    index.clear();
+    normalized.clear();
+    built.clear();
+    counters = {expr.size(), 0, 0, false};
+    allowance = budget ? budget : 32 * counters.before + 4096;
+
+    TermId root = normalize(*expr.arena, expr.id);
+    std::shared_ptr<Arena> target = Expression<T>::writableArena(expr);
+    Expression<T> result(target, build(*target, root));
+
+    counters.after = result.size();
+    if (counters.after > counters.before) {
+        counters.after = counters.before;
+        return expr;
+    }
+    return result;
+}
+
+template <typename T>
+const typename ExpressionSimplifier<T>::Stats& ExpressionSimplifier<T>::stats() const {
+    return counters;
+}
+
+template <typename T>
+bool ExpressionSimplifier<T>::spend(size_t cost) {
+    counters.work += cost;
+    if (counters.work > allowance) counters.exhausted = true;
+    return !counters.exhausted;
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::intern(Term term) {
+    std::string key;
+    appendBytes(key, term.kind);
+    appendBytes(key, term.function);
+    appendBytes(key, term.symbol);
+    appendBytes(key, term.value);
+    for (const Part& part : term.parts) {
+        appendBytes(key, part.term);
+        appendBytes(key, part.weight);
+    }
+    auto it = index.find(key);
+    if (it != index.end()) return it->second;
+    TermId id = static_cast<TermId>(terms.size());
+    terms.push_back(std::move(term));
+    index.emplace(std::move(key), id);
+    return id;
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::normalize(const Arena& arena, unsigned int id) {
+    auto it = normalized.find(id);
+    if (it != normalized.end()) return it->second;
+    const typename Arena::Node n = arena.node(id);
+    TermId result;
+    if (n.type == Arena::CONSTANT) {
+        result = constant(n.value);
+    } else if (n.type == Arena::VARIABLE) {
+        result = variable(n.symbol);
+    } else if (n.type == Arena::FUNCTION) {
+        TermId arg = normalize(arena, n.left);
+        result = counters.exhausted ? intern({FUNCTION, n.function, 0, T(0), {{arg, T(1)}}}) : function(n.function, arg);
+    } else if (!spend(1)) {
+        TermId lhs = normalize(arena, n.left);
+        result = opaque(n.operation, lhs, normalize(arena, n.right));
+    } else if (n.operation == '+' || n.operation == '-') {
+        result = normalizeChain(arena, id, true);
+    } else if (n.operation == '*' || n.operation == '/') {
+        result = normalizeChain(arena, id, false);
+    } else {
+        TermId base = normalize(arena, n.left);
+        result = power(base, normalize(arena, n.right));
+    }
+    normalized.emplace(id, result);
+    return result;
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::normalizeChain(const Arena& arena, unsigned int id, bool additive) {
+    std::vector<Part> leaves;
+    for (unsigned int current = id;;) {
+        const typename Arena::Node n = arena.node(current);
+        bool chained = n.type == Arena::OPERATION
+            && (additive ? n.operation == '+' || n.operation == '-' : n.operation == '*' || n.operation == '/');
+        if (!chained || (current != id && normalized.count(current))) {
+            leaves.push_back({normalize(arena, current), T(1)});
+            break;
+        }
+        TermId rhs = normalize(arena, n.right);
+        if (n.operation == '/' && terms[rhs].kind == CONSTANT && terms[rhs].value == T(0)) {
+            leaves.push_back({opaque('/', normalize(arena, n.left), rhs), T(1)});
+            break;
+        }
+        leaves.push_back({rhs, n.operation == '-' || n.operation == '/' ? T(-1) : T(1)});
+        current = n.left;
+    }
+    return additive ? sum(leaves) : product(leaves);
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::constant(T value) {
+    return intern({CONSTANT, 0, 0, value, {}});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::variable(unsigned int symbol) {
+    return intern({VARIABLE, 0, symbol, T(0), {}});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::function(unsigned char code, TermId arg) {
+    const Term a = terms[arg];
+    if (a.kind == CONSTANT) {
+        switch (code) {
+        case Arena::SIN: return constant(std::sin(a.value));
+        case Arena::COS: return constant(std::cos(a.value));
+        case Arena::EXP: return constant(std::exp(a.value));
+        case Arena::LN:
+            if (!isNegative(a.value) && a.value != T(0)) return constant(std::log(a.value));
+            break;
+        default: break;
+        }
+    }
+    if (std::is_floating_point_v<T> && code == Arena::LN && a.kind == FUNCTION && a.function == Arena::EXP) return a.parts[0].term;
+    return intern({FUNCTION, code, 0, T(0), {{arg, T(1)}}});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::power(TermId base, TermId exponent) {
+    const Term& e = terms[exponent];
+    if (e.kind == CONSTANT) {
+        T value = e.value;
+        if (terms[base].kind == CONSTANT) return constant(std::pow(terms[base].value, value));
+        if (value == T(0)) return constant(T(1));
+        if (value == T(1)) return base;
+        if (isSmallInteger(value)) return product({{base, value}});
+    }
+    return intern({POWER, 0, 0, T(0), {{base, T(1)}, {exponent, T(1)}}});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::opaque(char op, TermId lhs, TermId rhs) {
+    return intern({OPAQUE, static_cast<unsigned char>(op), 0, T(0), {{lhs, T(1)}, {rhs, T(1)}}});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::scale(TermId term, T factor) {
+    if (factor == T(1)) return term;
+    if (factor == T(0)) return constant(T(0));
+    Term t = terms[term];
+    if (t.kind == CONSTANT) return constant(t.value * factor);
+    if (t.kind != PRODUCT) return intern({PRODUCT, 0, 0, factor, {{term, T(1)}}});
+    t.value *= factor;
+    if (t.value == T(1) && t.parts.size() == 1 && t.parts[0].weight == T(1)) return t.parts[0].term;
+    return intern(std::move(t));
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::sum(const std::vector<Part>& leaves) {
+    T offset(0);
+    std::vector<Part> parts;
+    std::unordered_map<TermId, size_t> slots;
+    std::vector<Part> pending(leaves.rbegin(), leaves.rend());
+    while (!pending.empty()) {
+        Part leaf = pending.back();
+        pending.pop_back();
+        const Term& t = terms[leaf.term];
+        if (t.kind == CONSTANT) {
+            offset += leaf.weight * t.value;
+        } else if (t.kind == SUM) {
+            offset += leaf.weight * t.value;
+            for (const Part& p : t.parts) pending.push_back({p.term, p.weight * leaf.weight});
+        } else if (t.kind == PRODUCT && t.value != T(1)) {
+            Term unit = t;
+            T weight = t.value * leaf.weight;
+            unit.value = T(1);
+            TermId base = unit.parts.size() == 1 && unit.parts[0].weight == T(1) ? unit.parts[0].term : intern(std::move(unit));
+            pending.push_back({base, weight});
+        } else {
+            auto [it, inserted] = slots.emplace(leaf.term, parts.size());
+            if (inserted) parts.push_back(leaf);
+            else parts[it->second].weight += leaf.weight;
+        }
+    }
+    spend(leaves.size() + parts.size());
+    parts.erase(std::remove_if(parts.begin(), parts.end(), [](const Part& p) { return p.weight == T(0); }), parts.end());
+    std::sort(parts.begin(), parts.end(), [this](const Part& a, const Part& b) { return compare(a.term, b.term) < 0; });
+    if (parts.empty()) return constant(offset);
+    if (parts.size() == 1 && offset == T(0)) return scale(parts[0].term, parts[0].weight);
+    return intern({SUM, 0, 0, offset, std::move(parts)});
+}
+
+template <typename T>
+typename ExpressionSimplifier<T>::TermId ExpressionSimplifier<T>::product(const std::vector<Part>& leaves) {
+    T coefficient(1);
+    std::vector<Part> parts;
+    std::unordered_map<TermId, size_t> slots;
+    auto addFactor = [&parts, &slots](TermId term, T exponent) {
+        auto [it, inserted] = slots.emplace(term, parts.size());
+        if (inserted) parts.push_back({term, exponent});
+        else parts[it->second].weight += exponent;
+    };
+    for (const Part& leaf : leaves) {
+        const Term& t = terms[leaf.term];
+        if (t.kind == CONSTANT) {
+            coefficient *= leaf.weight == T(1) ? t.value : leaf.weight == T(-1) ? T(1) / t.value : std::pow(t.value, leaf.weight);
+        } else if (t.kind == PRODUCT) {
+            coefficient *= leaf.weight == T(1) ? t.value : std::pow(t.value, leaf.weight);
+            for (const Part& p : t.parts) addFactor(p.term, p.weight * leaf.weight);
+        } else {
+            addFactor(leaf.term, leaf.weight);
+        }
+    }
+    spend(leaves.size() + parts.size());
+    parts.erase(std::remove_if(parts.begin(), parts.end(), [](const Part& p) { return p.weight == T(0); }), parts.end());
+
+    std::vector<Part> exponents;
+    for (const Part& p : parts) {
+        if (terms[p.term].kind == FUNCTION && terms[p.term].function == Arena::EXP) exponents.push_back({terms[p.term].parts[0].term, p.weight});
+    }
+    if (exponents.size() > 1) {
+        parts.erase(std::remove_if(parts.begin(), parts.end(), [this](const Part& p) {
+            return terms[p.term].kind == FUNCTION && terms[p.term].function == Arena::EXP;
+        }), parts.end());
+        TermId merged = function(Arena::EXP, sum(exponents));
+        if (terms[merged].kind == CONSTANT) coefficient *= terms[merged].value;
+        else parts.push_back({merged, T(1)});
+    }
+
+    if (coefficient == T(0)) return constant(T(0));
+    std::sort(parts.begin(), parts.end(), [this](const Part& a, const Part& b) { return compare(a.term, b.term) < 0; });
+    if (parts.empty()) return constant(coefficient);
+    if (parts.size() == 1 && parts[0].weight == T(1) && coefficient == T(1)) return parts[0].term;
+    return intern({PRODUCT, 0, 0, coefficient, std::move(parts)});
+}
+
+template <typename T>
+int ExpressionSimplifier<T>::compare(TermId a, TermId b) const {
+    if (a == b) return 0;
+    const Term& x = terms[a];
+    const Term& y = terms[b];
+    if (x.kind != y.kind) return x.kind < y.kind ? -1 : 1;
+    if (x.kind == CONSTANT) return compareValue(x.value, y.value);
+    if (x.kind == VARIABLE) return SymbolTable::name(x.symbol).compare(SymbolTable::name(y.symbol));
+    if (x.function != y.function) return x.function < y.function ? -1 : 1;
+    for (size_t i = 0; i < x.parts.size() && i < y.parts.size(); i++) {
+        if (int c = compare(x.parts[i].term, y.parts[i].term)) return c;
+        if (int c = compareValue(x.parts[i].weight, y.parts[i].weight)) return c;
+    }
+    if (x.parts.size() != y.parts.size()) return x.parts.size() < y.parts.size() ? -1 : 1;
+    return compareValue(x.value, y.value);
+}
+
+template <typename T>
+unsigned int ExpressionSimplifier<T>::buildConstant(Arena& arena, T value) {
+    return arena.add({Arena::CONSTANT, '\0', 0, 0, 0, 0, 0, value});
+}
+
+template <typename T>
+unsigned int ExpressionSimplifier<T>::build(Arena& arena, TermId term) {
+    auto it = built.find(term);
+    if (it != built.end()) return it->second;
+    const Term t = terms[term];
+    auto binary = [&arena](char op, unsigned int lhs, unsigned int rhs) {
+        return arena.add({Arena::OPERATION, op, 0, 0, 0, lhs, rhs, T(0)});
+    };
+    unsigned int result = 0;
+    switch (t.kind) {
+    case CONSTANT:
+        result = buildConstant(arena, t.value);
+        break;
+    case VARIABLE:
+        result = arena.add({Arena::VARIABLE, '\0', 0, 0, t.symbol, 0, 0, T(0)});
+        break;
+    case FUNCTION:
+        result = arena.add({Arena::FUNCTION, '\0', t.function, 0, 0, build(arena, t.parts[0].term), 0, T(0)});
+        break;
+    case POWER:
+    case OPAQUE: {
+        unsigned int lhs = build(arena, t.parts[0].term);
+        result = binary(t.kind == POWER ? '^' : static_cast<char>(t.function), lhs, build(arena, t.parts[1].term));
+        break;
+    }
+    case PRODUCT: {
+        bool hasNumerator = t.value != T(1);
+        bool hasDenominator = false;
+        unsigned int numerator = hasNumerator ? buildConstant(arena, t.value) : 0;
+        unsigned int denominator = 0;
+        for (const Part& p : t.parts) {
+            bool inverse = isNegative(p.weight);
+            T exponent = inverse ? -p.weight : p.weight;
+            unsigned int factor = build(arena, p.term);
+            if (exponent != T(1)) factor = binary('^', factor, buildConstant(arena, exponent));
+            if (inverse) {
+                denominator = hasDenominator ? binary('*', denominator, factor) : factor;
+                hasDenominator = true;
+            } else {
+                numerator = hasNumerator ? binary('*', numerator, factor) : factor;
+                hasNumerator = true;
+            }
+        }
+        if (!hasNumerator) numerator = buildConstant(arena, T(1));
+        result = hasDenominator ? binary('/', numerator, denominator) : numerator;
+        break;
+    }
+    case SUM: {
+        bool first = true;
+        for (const Part& p : t.parts) {
+            bool minus = !first && isNegative(p.weight);
+            unsigned int addend = build(arena, scale(p.term, minus ? -p.weight : p.weight));
+            result = first ? addend : binary(minus ? '-' : '+', result, addend);
+            first = false;
+        }
+        if (t.value != T(0)) {
+            bool minus = isNegative(t.value);
+            result = binary(minus ? '-' : '+', result, buildConstant(arena, minus ? -t.value : t.value));
+        }
+        break;
+    }
+    }
+    built.emplace(term, result);
+    return result;
+}
+
+template class ExpressionSimplifier<double>;
+template class ExpressionSimplifier<std::complex<double>>;
\ No newline at end of file
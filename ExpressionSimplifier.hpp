@@ -0,0 +1,66 @@
+#ifndef EXPRESSION_SIMPLIFIER_HPP
+#define EXPRESSION_SIMPLIFIER_HPP
+
+#include "Expression.hpp"
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+template <typename T>
+class ExpressionSimplifier {
+public:
+    struct Stats {
+        size_t before;
+        size_t after;
+        size_t work;
+        bool exhausted;
+    };
+
+    explicit ExpressionSimplifier(size_t budget = 0);
+    Expression<T> simplify(const Expression<T>& expr);
+    const Stats& stats() const;
+
+private:
+    typedef ExpressionArena<T> Arena;
+    typedef unsigned int TermId;
+    enum Kind : unsigned char { CONSTANT, VARIABLE, FUNCTION, POWER, OPAQUE, PRODUCT, SUM };
+
+    struct Part {
+        TermId term;
+        T weight;
+    };
+
+    struct Term {
+        Kind kind;
+        unsigned char function;
+        unsigned int symbol;
+        T value;
+        std::vector<Part> parts;
+    };
+
+    TermId normalize(const Arena& arena, unsigned int id);
+    TermId normalizeChain(const Arena& arena, unsigned int id, bool additive);
+    TermId constant(T value);
+    TermId variable(unsigned int symbol);
+    TermId function(unsigned char code, TermId arg);
+    TermId power(TermId base, TermId exponent);
+    TermId opaque(char op, TermId lhs, TermId rhs);
+    TermId sum(const std::vector<Part>& leaves);
+    TermId product(const std::vector<Part>& leaves);
+    TermId scale(TermId term, T factor);
+    TermId intern(Term term);
+    int compare(TermId a, TermId b) const;
+    bool spend(size_t cost);
+    unsigned int build(Arena& arena, TermId term);
+    unsigned int buildConstant(Arena& arena, T value);
+
+    std::vector<Term> terms;
+    std::unordered_map<std::string, TermId> index;
+    std::unordered_map<unsigned int, TermId> normalized;
+    std::unordered_map<TermId, unsigned int> built;
+    size_t budget;
+    size_t allowance;
+    Stats counters;
+};
+
+#endif
\ No newline at end of file
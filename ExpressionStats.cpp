@@ -0,0 +1,119 @@
+#include "ExpressionStats.hpp"
+#include <iomanip>
+
+namespace {
+
+const char* const phaseNames[] = {"parse", "differentiate", "simplify", "toString", "evaluate", "compile", "evaluateBatch"};
+
+struct Totals {
+    std::atomic<uint64_t> nodesCreated{0};
+    std::atomic<uint64_t> liveNodes{0};
+    std::atomic<uint64_t> peakLiveNodes{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+    std::atomic<uint64_t> maxDepth{0};
+    std::atomic<uint64_t> differentiatedNodes{0};
+    std::atomic<uint64_t> derivativeNodes{0};
+    std::atomic<uint64_t> calls[ExpressionStats::PHASES] = {};
+    std::atomic<uint64_t> nanoseconds[ExpressionStats::PHASES] = {};
+};
+
+Totals totals;
+
+void raise(std::atomic<uint64_t>& peak, uint64_t value) {
+    uint64_t seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+}
+
+std::atomic<bool> ExpressionStats::active{false};
+
+ExpressionStats::Timer::Timer(Phase phase) : phase(phase), running(enabled()) {
+    if (running) start = std::chrono::steady_clock::now();
+}
+
+ExpressionStats::Timer::~Timer() {
+    if (!running) return;
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    totals.calls[phase].fetch_add(1, std::memory_order_relaxed);
+    totals.nanoseconds[phase].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+}
+
+void ExpressionStats::enable(bool on) {
+    active.store(on, std::memory_order_relaxed);
+}
+
+void ExpressionStats::reset() {
+    totals.nodesCreated = 0;
+    totals.peakLiveNodes = totals.liveNodes.load();
+    totals.allocations = 0;
+    totals.allocatedBytes = 0;
+    totals.maxDepth = 0;
+    totals.differentiatedNodes = 0;
+    totals.derivativeNodes = 0;
+    for (size_t i = 0; i < PHASES; i++) {
+        totals.calls[i] = 0;
+        totals.nanoseconds[i] = 0;
+    }
+}
+
+ExpressionStats::Counters ExpressionStats::counters() {
+    Counters result;
+    result.nodesCreated = totals.nodesCreated.load();
+    result.liveNodes = totals.liveNodes.load();
+    result.peakLiveNodes = totals.peakLiveNodes.load();
+    result.allocations = totals.allocations.load();
+    result.allocatedBytes = totals.allocatedBytes.load();
+    result.maxDepth = totals.maxDepth.load();
+    result.differentiatedNodes = totals.differentiatedNodes.load();
+    result.derivativeNodes = totals.derivativeNodes.load();
+    for (size_t i = 0; i < PHASES; i++) {
+        result.calls[i] = totals.calls[i].load();
+        result.nanoseconds[i] = totals.nanoseconds[i].load();
+    }
+    return result;
+}
+
+void ExpressionStats::report(std::ostream& out) {
+    Counters c = counters();
+    out << "nodes created: " << c.nodesCreated << "\n";
+    out << "peak live nodes: " << c.peakLiveNodes << "\n";
+    out << "heap allocations: " << c.allocations << " (" << c.allocatedBytes << " bytes)\n";
+    out << "max depth: " << c.maxDepth << "\n";
+    if (c.differentiatedNodes) {
+        out << "derivative nodes: " << c.derivativeNodes << " from " << c.differentiatedNodes << " (x"
+            << std::fixed << std::setprecision(2) << static_cast<double>(c.derivativeNodes) / c.differentiatedNodes << ")\n";
+    }
+    for (size_t i = 0; i < PHASES; i++) {
+        if (!c.calls[i]) continue;
+        out << phaseNames[i] << ": " << c.calls[i] << (c.calls[i] == 1 ? " call, " : " calls, ")
+            << std::fixed << std::setprecision(3) << c.nanoseconds[i] / 1e6 << " ms\n";
+    }
+    out.unsetf(std::ios_base::floatfield);
+    out << std::setprecision(6);
+}
+
+void ExpressionStats::nodesAdded(uint64_t count) {
+    totals.nodesCreated.fetch_add(count, std::memory_order_relaxed);
+    raise(totals.peakLiveNodes, totals.liveNodes.fetch_add(count, std::memory_order_relaxed) + count);
+}
+
+void ExpressionStats::nodesReleased(uint64_t count) {
+    totals.liveNodes.fetch_sub(count, std::memory_order_relaxed);
+}
+
+void ExpressionStats::allocated(uint64_t bytes) {
+    totals.allocations.fetch_add(1, std::memory_order_relaxed);
+    totals.allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ExpressionStats::depth(uint64_t levels) {
+    raise(totals.maxDepth, levels);
+}
+
+void ExpressionStats::derivative(uint64_t inputNodes, uint64_t outputNodes) {
+    totals.differentiatedNodes.fetch_add(inputNodes, std::memory_order_relaxed);
+    totals.derivativeNodes.fetch_add(outputNodes, std::memory_order_relaxed);
+}
\ No newline at end of file
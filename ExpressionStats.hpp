@@ -0,0 +1,60 @@
+#ifndef EXPRESSION_STATS_HPP
+#define EXPRESSION_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Process-wide counters for the expression library. Everything is off until
+// enable() is called; while off each hook costs one relaxed load and a branch.
+class ExpressionStats {
+public:
+    enum Phase { PARSE, DIFFERENTIATE, SIMPLIFY, TO_STRING, EVALUATE, COMPILE, BATCH, PHASES };
+
+    struct Counters {
+        uint64_t nodesCreated;
+        uint64_t liveNodes;
+        uint64_t peakLiveNodes;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+        uint64_t maxDepth;
+        uint64_t differentiatedNodes;
+        uint64_t derivativeNodes;
+        uint64_t calls[PHASES];
+        uint64_t nanoseconds[PHASES];
+    };
+
+    class Timer {
+    public:
+        explicit Timer(Phase phase);
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Phase phase;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    static void enable(bool on = true);
+    static void reset();
+    static Counters counters();
+    static void report(std::ostream& out);
+
+    static void nodesAdded(uint64_t count);
+    static void nodesReleased(uint64_t count);
+    static void allocated(uint64_t bytes);
+    static void depth(uint64_t levels);
+    static void derivative(uint64_t inputNodes, uint64_t outputNodes);
+
+private:
+    static std::atomic<bool> active;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "ExpressionSystem.hpp"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+template <typename T>
+ExpressionSystem<T>::ExpressionSystem(const std::vector<Expression<T>>& exprs, const std::vector<std::string>& variables)
+    : variableNames(variables),
+      hessianEntries(exprs.size()),
+      hessianBuilt(exprs.size(), 0),
+      jacobianBuilt(false) {
+    for (size_t i = 0; i < variables.size(); i++) {
+        if (!columns.emplace(variables[i], i).second) throw std::invalid_argument("Variable '" + variables[i] + "' is listed twice.");
+    }
+    for (const Expression<T>& expr : exprs) roots.push_back(dag.fromExpression(expr));
+}
+
+template <typename T>
+const std::vector<size_t>& ExpressionSystem<T>::dependencies(NodeId id) {
+    typedef ExpressionDag<T> Dag;
+    for (size_t i = dependsOn.size(); i < dag.size(); i++) {
+        const typename Dag::Node& n = dag.node(static_cast<NodeId>(i));
+        std::vector<size_t> deps;
+        if (n.kind == Dag::VARIABLE) {
+            auto it = columns.find(dag.variableName(static_cast<NodeId>(i)));
+            if (it != columns.end()) deps.push_back(it->second);
+        } else if (n.kind >= Dag::SIN) {
+            deps = dependsOn[n.left];
+        } else if (n.kind != Dag::CONSTANT) {
+            const std::vector<size_t>& l = dependsOn[n.left];
+            const std::vector<size_t>& r = dependsOn[n.right];
+            std::set_union(l.begin(), l.end(), r.begin(), r.end(), std::back_inserter(deps));
+        }
+        dependsOn.push_back(std::move(deps));
+    }
+    return dependsOn[id];
+}
+
+template <typename T>
+bool ExpressionSystem<T>::isZero(NodeId id) const {
+    const typename ExpressionDag<T>::Node& n = dag.node(id);
+    return n.kind == ExpressionDag<T>::CONSTANT && n.value == T(0);
+}
+
+template <typename T>
+const std::vector<typename ExpressionSystem<T>::Entry>& ExpressionSystem<T>::jacobian() {
+    if (jacobianBuilt) return jacobianEntries;
+    for (size_t row = 0; row < roots.size(); row++) {
+        std::vector<size_t> cols = dependencies(roots[row]);
+        for (size_t col : cols) {
+            NodeId d = dag.differentiate(roots[row], variableNames[col]);
+            if (!isZero(d)) jacobianEntries.push_back({row, col, d});
+        }
+    }
+    jacobianBuilt = true;
+    return jacobianEntries;
+}
+
+template <typename T>
+const std::vector<typename ExpressionSystem<T>::Entry>& ExpressionSystem<T>::hessian(size_t expression) {
+    if (expression >= roots.size()) throw std::out_of_range("Expression index out of range.");
+    if (hessianBuilt[expression]) return hessianEntries[expression];
+    std::vector<size_t> cols = dependencies(roots[expression]);
+    for (size_t row : cols) {
+        NodeId first = dag.differentiate(roots[expression], variableNames[row]);
+        std::vector<size_t> inner = dependencies(first);
+        for (size_t col : inner) {
+            if (col < row) continue;
+            NodeId second = dag.differentiate(first, variableNames[col]);
+            if (!isZero(second)) hessianEntries[expression].push_back({row, col, second});
+        }
+    }
+    hessianBuilt[expression] = 1;
+    return hessianEntries[expression];
+}
+
+template <typename T>
+std::vector<T> ExpressionSystem<T>::evaluate(const std::vector<Entry>& entries, const std::vector<T>& values) const {
+    if (values.size() < variableNames.size()) throw std::invalid_argument("Not enough variable values.");
+    std::map<std::string, T> bound;
+    for (size_t i = 0; i < variableNames.size(); i++) bound[variableNames[i]] = values[i];
+    return evaluate(entries, bound);
+}
+
+template <typename T>
+std::vector<T> ExpressionSystem<T>::evaluate(const std::vector<Entry>& entries, const std::map<std::string, T>& values) const {
+    std::vector<NodeId> nodes;
+    nodes.reserve(entries.size());
+    for (const Entry& entry : entries) nodes.push_back(entry.node);
+    return dag.evaluate(nodes, values);
+}
+
+template <typename T>
+Expression<T> ExpressionSystem<T>::expression(const Entry& entry) const {
+    return dag.toExpression(entry.node);
+}
+
+template <typename T>
+size_t ExpressionSystem<T>::rows() const {
+    return roots.size();
+}
+
+template <typename T>
+size_t ExpressionSystem<T>::cols() const {
+    return variableNames.size();
+}
+
+template <typename T>
+const std::vector<std::string>& ExpressionSystem<T>::variables() const {
+    return variableNames;
+}
+
+template <typename T>
+size_t ExpressionSystem<T>::nodes() const {
+    return dag.size();
+}
+
+template class ExpressionSystem<double>;
+template class ExpressionSystem<std::complex<double>>;
\ No newline at end of file
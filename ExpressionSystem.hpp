@@ -0,0 +1,52 @@
+#ifndef EXPRESSION_SYSTEM_HPP
+#define EXPRESSION_SYSTEM_HPP
+
+#include "Expression.hpp"
+#include "ExpressionDag.hpp"
+#include <vector>
+#include <string>
+#include <map>
+
+template <typename T>
+class ExpressionSystem {
+public:
+    typedef typename ExpressionDag<T>::NodeId NodeId;
+
+    struct Entry {
+        size_t row;
+        size_t col;
+        NodeId node;
+    };
+
+    ExpressionSystem(const std::vector<Expression<T>>& exprs, const std::vector<std::string>& variables);
+
+    const std::vector<Entry>& jacobian();
+    const std::vector<Entry>& hessian(size_t expression);
+
+    // values are in variables() order; the map form also binds variables
+    // that are held fixed rather than differentiated.
+    std::vector<T> evaluate(const std::vector<Entry>& entries, const std::vector<T>& values) const;
+    std::vector<T> evaluate(const std::vector<Entry>& entries, const std::map<std::string, T>& values) const;
+    Expression<T> expression(const Entry& entry) const;
+
+    size_t rows() const;
+    size_t cols() const;
+    const std::vector<std::string>& variables() const;
+    size_t nodes() const;
+
+private:
+    const std::vector<size_t>& dependencies(NodeId id);
+    bool isZero(NodeId id) const;
+
+    ExpressionDag<T> dag;
+    std::vector<NodeId> roots;
+    std::vector<std::string> variableNames;
+    std::map<std::string, size_t> columns;
+    std::vector<std::vector<size_t>> dependsOn;
+    std::vector<Entry> jacobianEntries;
+    std::vector<std::vector<Entry>> hessianEntries;
+    std::vector<char> hessianBuilt;
+    bool jacobianBuilt;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "IncrementalEvaluator.hpp"
+#include "ExpressionMath.hpp"
+#include "SymbolTable.hpp"
+#include <cstring>
+#include <unordered_map>
+
+template <typename T>
+IncrementalEvaluator<T>::IncrementalEvaluator(const Expression<T>& expr)
+    : variableNames(expr.variables()), lastRecomputed(0), ready(false) {
+    build(expr);
+}
+
+template <typename T>
+IncrementalEvaluator<T>::IncrementalEvaluator(const Expression<T>& expr, const std::vector<std::string>& order)
+    : variableNames(order), lastRecomputed(0), ready(false) {
+    build(expr);
+}
+
+template <typename T>
+void IncrementalEvaluator<T>::build(const Expression<T>& expr) {
+    typedef ExpressionArena<T> Arena;
+    const Arena& arena = *expr.arena;
+    std::unordered_map<unsigned int, unsigned int> slots;
+    for (size_t i = 0; i < variableNames.size(); i++) {
+        slots[SymbolTable::intern(variableNames[i])] = static_cast<unsigned int>(i);
+    }
+    leaves.assign(variableNames.size(), static_cast<unsigned int>(-1));
+    assigned.assign(variableNames.size(), 0);
+
+    std::unordered_map<unsigned int, unsigned int> seen;
+    std::vector<std::pair<unsigned int, bool>> pending{{expr.id, false}};
+    while (!pending.empty()) {
+        auto [id, expanded] = pending.back();
+        if (seen.count(id)) {
+            pending.pop_back();
+            continue;
+        }
+        const typename Arena::Node& n = arena.node(id);
+        bool hasChildren = n.type == Arena::OPERATION || n.type == Arena::FUNCTION;
+        if (hasChildren && !expanded) {
+            pending.back().second = true;
+            if (n.type == Arena::OPERATION) pending.push_back({n.right, false});
+            pending.push_back({n.left, false});
+            continue;
+        }
+        pending.pop_back();
+        Node node{CONSTANT, 0, 0};
+        T value = T(0);
+        if (n.type == Arena::CONSTANT) {
+            value = n.value;
+        } else if (n.type == Arena::VARIABLE) {
+            auto it = slots.find(n.symbol);
+            if (it == slots.end()) throw std::invalid_argument("Variable '" + SymbolTable::name(n.symbol) + "' is not bound.");
+            if (leaves[it->second] != static_cast<unsigned int>(-1)) {
+                seen.emplace(id, leaves[it->second]);
+                continue;
+            }
+            node = {VARIABLE, it->second, 0};
+            leaves[it->second] = static_cast<unsigned int>(nodes.size());
+        } else if (n.type == Arena::FUNCTION) {
+            switch (n.function) {
+            case Arena::SIN: node.kind = SIN; break;
+            case Arena::COS: node.kind = COS; break;
+            case Arena::LN: node.kind = LN; break;
+            case Arena::EXP: node.kind = EXP; break;
+            default: throw std::runtime_error("Unknown function");
+            }
+            node.left = seen.at(n.left);
+        } else {
+            switch (n.operation) {
+            case '+': node.kind = ADD; break;
+            case '-': node.kind = SUB; break;
+            case '*': node.kind = MUL; break;
+            case '/': node.kind = DIV; break;
+            case '^': node.kind = POW; break;
+            default: throw std::runtime_error("Unknown operation");
+            }
+            node.left = seen.at(n.left);
+            node.right = seen.at(n.right);
+        }
+        seen.emplace(id, static_cast<unsigned int>(nodes.size()));
+        nodes.push_back(node);
+        values.push_back(value);
+    }
+
+    parentOffsets.assign(nodes.size() + 1, 0);
+    for (const Node& n : nodes) {
+        if (n.kind >= ADD) parentOffsets[n.left + 1]++;
+        if (n.kind >= ADD && n.kind <= POW) parentOffsets[n.right + 1]++;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) parentOffsets[i + 1] += parentOffsets[i];
+    parents.resize(parentOffsets.back());
+    std::vector<unsigned int> fill(parentOffsets.begin(), parentOffsets.end() - 1);
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        if (nodes[i].kind >= ADD) parents[fill[nodes[i].left]++] = i;
+        if (nodes[i].kind >= ADD && nodes[i].kind <= POW) parents[fill[nodes[i].right]++] = i;
+    }
+    queued.assign(nodes.size(), 0);
+}
+
+template <typename T>
+T IncrementalEvaluator<T>::compute(unsigned int id) const {
+    const Node& n = nodes[id];
+    switch (n.kind) {
+    case CONSTANT: case VARIABLE: return values[id];
+    case ADD: return values[n.left] + values[n.right];
+    case SUB: return values[n.left] - values[n.right];
+    case MUL: return values[n.left] * values[n.right];
+    case DIV: return expressionDivide(values[n.left], values[n.right]);
+    case POW: return std::pow(values[n.left], values[n.right]);
+    case SIN: return std::sin(values[n.left]);
+    case COS: return std::cos(values[n.left]);
+    case LN: return expressionLog(values[n.left]);
+    case EXP: return std::exp(values[n.left]);
+    }
+    throw std::runtime_error("Unknown operation");
+}
+
+template <typename T>
+void IncrementalEvaluator<T>::touch(unsigned int id) {
+    for (unsigned int p = parentOffsets[id]; p < parentOffsets[id + 1]; p++) {
+        unsigned int parent = parents[p];
+        if (queued[parent]) continue;
+        queued[parent] = 1;
+        dirty.push(parent);
+    }
+}
+
+template <typename T>
+void IncrementalEvaluator<T>::set(size_t slot, T value) {
+    if (slot >= variableNames.size()) throw std::out_of_range("Variable slot out of range.");
+    assigned[slot] = 1;
+    unsigned int leaf = leaves[slot];
+    if (leaf == static_cast<unsigned int>(-1)) return;
+    if (std::memcmp(&values[leaf], &value, sizeof(T)) == 0) return;
+    values[leaf] = value;
+    if (ready) touch(leaf);
+}
+
+template <typename T>
+void IncrementalEvaluator<T>::set(const std::string& var, T value) {
+    set(slot(var), value);
+}
+
+template <typename T>
+T IncrementalEvaluator<T>::value() {
+    if (!ready) {
+        for (size_t i = 0; i < variableNames.size(); i++) {
+            if (!assigned[i] && leaves[i] != static_cast<unsigned int>(-1)) throw std::invalid_argument("Variable '" + variableNames[i] + "' has no value.");
+        }
+        for (unsigned int i = 0; i < nodes.size(); i++) values[i] = compute(i);
+        lastRecomputed = nodes.size();
+        ready = true;
+        return values.back();
+    }
+    lastRecomputed = 0;
+    while (!dirty.empty()) {
+        unsigned int id = dirty.top();
+        dirty.pop();
+        queued[id] = 0;
+        T updated = compute(id);
+        lastRecomputed++;
+        if (std::memcmp(&values[id], &updated, sizeof(T)) == 0) continue;
+        values[id] = updated;
+        touch(id);
+    }
+    return values.back();
+}
+
+template <typename T>
+const std::vector<std::string>& IncrementalEvaluator<T>::variables() const {
+    return variableNames;
+}
+
+template <typename T>
+size_t IncrementalEvaluator<T>::slot(const std::string& var) const {
+    for (size_t i = 0; i < variableNames.size(); i++) {
+        if (variableNames[i] == var) return i;
+    }
+    throw std::out_of_range("Unknown variable: '" + var + "'");
+}
+
+template <typename T>
+size_t IncrementalEvaluator<T>::size() const {
+    return nodes.size();
+}
+
+template <typename T>
+size_t IncrementalEvaluator<T>::recomputed() const {
+    return lastRecomputed;
+}
+
+template class IncrementalEvaluator<double>;
+template class IncrementalEvaluator<std::complex<double>>;
\ No newline at end of file
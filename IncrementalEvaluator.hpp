@@ -0,0 +1,54 @@
+#ifndef INCREMENTAL_EVALUATOR_HPP
+#define INCREMENTAL_EVALUATOR_HPP
+
+#include "Expression.hpp"
+#include <vector>
+#include <string>
+#include <queue>
+#include <functional>
+
+// Keeps the value of every subtree of one expression. set() only marks the
+// nodes above the changed variable; value() recomputes those bottom-up and
+// stops climbing wherever a recomputed value is bit-identical to the old one.
+template <typename T>
+class IncrementalEvaluator {
+public:
+    explicit IncrementalEvaluator(const Expression<T>& expr);
+    IncrementalEvaluator(const Expression<T>& expr, const std::vector<std::string>& order);
+
+    void set(const std::string& var, T value);
+    void set(size_t slot, T value);
+    T value();
+
+    const std::vector<std::string>& variables() const;
+    size_t slot(const std::string& var) const;
+    size_t size() const;
+    size_t recomputed() const;
+
+private:
+    enum Kind : unsigned char { CONSTANT, VARIABLE, ADD, SUB, MUL, DIV, POW, SIN, COS, LN, EXP };
+
+    struct Node {
+        Kind kind;
+        unsigned int left;
+        unsigned int right;
+    };
+
+    void build(const Expression<T>& expr);
+    T compute(unsigned int id) const;
+    void touch(unsigned int id);
+
+    std::vector<Node> nodes;
+    std::vector<T> values;
+    std::vector<unsigned int> parentOffsets;
+    std::vector<unsigned int> parents;
+    std::vector<std::string> variableNames;
+    std::vector<unsigned int> leaves;
+    std::vector<char> assigned;
+    std::vector<char> queued;
+    std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int>> dirty;
+    size_t lastRecomputed;
+    bool ready;
+};
+
+#endif
\ No newline at end of file
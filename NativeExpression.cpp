@@ -0,0 +1,229 @@
+#include "NativeExpression.hpp"
+#include "ExpressionDag.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+typedef ExpressionDag<double> Dag;
+
+const char* const preamble =
+    "#include <math.h>\n"
+    "\n"
+    "static inline double expression_log(double a) { return a <= 0.0 ? -INFINITY : log(a); }\n";
+
+std::atomic<unsigned int> nextBuild{0};
+
+std::string literal(double value) {
+    if (std::isnan(value)) return "NAN";
+    if (std::isinf(value)) return value < 0 ? "(-INFINITY)" : "INFINITY";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%a", value);
+    return std::signbit(value) ? "(" + std::string(text) + ")" : std::string(text);
+}
+
+void emitFunction(std::ostream& out, const Dag& dag, Dag::NodeId root, const std::string& name,
+                  const std::unordered_map<std::string, size_t>& slots) {
+    std::vector<char> marked(root + 1, 0);
+    marked[root] = 1;
+    for (size_t i = marked.size(); i-- > 0;) {
+        if (!marked[i]) continue;
+        const Dag::Node& n = dag.node(static_cast<Dag::NodeId>(i));
+        if (n.kind == Dag::CONSTANT || n.kind == Dag::VARIABLE) continue;
+        marked[n.left] = 1;
+        if (n.kind <= Dag::POW) marked[n.right] = 1;
+    }
+
+    auto operand = [&dag, &slots](Dag::NodeId id) {
+        const Dag::Node& n = dag.node(id);
+        if (n.kind == Dag::CONSTANT) return literal(n.value);
+        if (n.kind == Dag::VARIABLE) return "v[" + std::to_string(slots.at(dag.variableName(id))) + "]";
+        return "t" + std::to_string(id);
+    };
+
+    out << "double " << name << "(const double* v) {\n";
+    for (size_t i = 0; i < marked.size(); i++) {
+        const Dag::Node& n = dag.node(static_cast<Dag::NodeId>(i));
+        if (!marked[i] || n.kind == Dag::CONSTANT || n.kind == Dag::VARIABLE) continue;
+        out << "    const double t" << i << " = ";
+        switch (n.kind) {
+        case Dag::ADD: out << operand(n.left) << " + " << operand(n.right); break;
+        case Dag::SUB: out << operand(n.left) << " - " << operand(n.right); break;
+        case Dag::MUL: out << operand(n.left) << " * " << operand(n.right); break;
+        case Dag::DIV: out << operand(n.left) << " / " << operand(n.right); break;
+        case Dag::POW: out << "pow(" << operand(n.left) << ", " << operand(n.right) << ")"; break;
+        case Dag::SIN: out << "sin(" << operand(n.left) << ")"; break;
+        case Dag::COS: out << "cos(" << operand(n.left) << ")"; break;
+        case Dag::LN: out << "expression_log(" << operand(n.left) << ")"; break;
+        case Dag::EXP: out << "exp(" << operand(n.left) << ")"; break;
+        default: throw std::runtime_error("Unknown operation");
+        }
+        out << ";\n";
+    }
+    out << "    return " << operand(root) << ";\n}\n";
+}
+
+std::string quote(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') quoted += "'\\''";
+        else quoted += c;
+    }
+    return quoted + "'";
+}
+
+uint64_t fingerprint(const std::string& text) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) h = (h ^ c) * 0x100000001b3ULL;
+    return h;
+}
+
+bool readFile(const std::string& file, std::string& contents) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return false;
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+}
+
+NativeExpression::NativeExpression(const Expression<double>& expr, const std::vector<std::string>& derivatives)
+    : NativeExpression(expr, derivatives, expr.variables()) {
+}
+
+NativeExpression::NativeExpression(const Expression<double>& expr, const std::vector<std::string>& derivatives,
+                                   const std::vector<std::string>& order)
+    : variableNames(order),
+      derivativeNames(derivatives),
+      handle(nullptr),
+      reused(false) {
+    load(source(expr, derivatives, order));
+}
+
+NativeExpression::~NativeExpression() {
+    if (handle) dlclose(handle);
+}
+
+std::string NativeExpression::source(const Expression<double>& expr, const std::vector<std::string>& derivatives,
+                                     const std::vector<std::string>& order) {
+    std::unordered_map<std::string, size_t> slots;
+    for (size_t i = 0; i < order.size(); i++) slots.emplace(order[i], i);
+    for (const std::string& var : expr.variables()) {
+        if (!slots.count(var)) throw std::invalid_argument("Variable '" + var + "' is not bound.");
+    }
+
+    Dag dag;
+    std::vector<Dag::NodeId> roots{dag.fromExpression(expr)};
+    std::vector<std::string> labels{expr.toString()};
+    for (const std::string& var : derivatives) {
+        Expression<double> derivative = expr.differentiate(var);
+        roots.push_back(dag.fromExpression(derivative));
+        labels.push_back("d/d" + var + " = " + derivative.toString());
+    }
+
+    std::ostringstream out;
+    out << preamble << "\n/*";
+    for (size_t i = 0; i < order.size(); i++) out << (i ? ", " : " ") << order[i] << " = v[" << i << "]";
+    out << " */\n";
+    for (size_t i = 0; i < roots.size(); i++) {
+        std::string name = i == 0 ? "f" : "f_d" + std::to_string(i - 1);
+        out << "\n/* " << name << ": " << labels[i] << " */\n";
+        emitFunction(out, dag, roots[i], name, slots);
+    }
+    return out.str();
+}
+
+std::string NativeExpression::cacheDirectory() {
+    if (const char* dir = std::getenv("EXPRESSION_CACHE_DIR")) return dir;
+    if (const char* dir = std::getenv("XDG_CACHE_HOME")) return std::string(dir) + "/differentiator";
+    if (const char* home = std::getenv("HOME")) return std::string(home) + "/.cache/differentiator";
+    return "/tmp/differentiator";
+}
+
+void NativeExpression::load(const std::string& code) {
+    std::string dir = cacheDirectory();
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+        mkdir(dir.substr(0, slash).c_str(), 0755);
+        if (slash == std::string::npos) break;
+    }
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(fingerprint(code)));
+    std::string base = dir + "/" + key;
+    path = base + ".so";
+
+    std::string existing;
+    reused = readFile(base + ".c", existing) && existing == code && access(path.c_str(), R_OK) == 0;
+    if (!reused) {
+        std::string temp = base + "." + std::to_string(getpid()) + "." + std::to_string(nextBuild++);
+        std::ofstream(temp + ".c", std::ios::binary) << code;
+        const char* cc = std::getenv("CC");
+        std::string command = std::string(cc ? cc : "cc") + " -O2 -fPIC -shared -ffp-contract=off -o " + quote(temp + ".so")
+            + " " + quote(temp + ".c") + " -lm > " + quote(temp + ".log") + " 2>&1";
+        int status = std::system(command.c_str());
+        std::string log;
+        readFile(temp + ".log", log);
+        std::remove((temp + ".log").c_str());
+        if (status != 0) {
+            std::remove((temp + ".c").c_str());
+            std::remove((temp + ".so").c_str());
+            throw std::runtime_error("Native compilation failed: " + log);
+        }
+        std::rename((temp + ".so").c_str(), path.c_str());
+        std::rename((temp + ".c").c_str(), (base + ".c").c_str());
+    }
+
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) throw std::runtime_error(std::string("Cannot load ") + path + ": " + dlerror());
+    for (size_t i = 0; i <= derivativeNames.size(); i++) {
+        std::string name = i == 0 ? "f" : "f_d" + std::to_string(i - 1);
+        Function function = reinterpret_cast<Function>(dlsym(handle, name.c_str()));
+        if (!function) {
+            dlclose(handle);
+            handle = nullptr;
+            throw std::runtime_error("Missing symbol " + name + " in " + path);
+        }
+        functions.push_back(function);
+    }
+}
+
+double NativeExpression::evaluate(const double* values) const {
+    return functions[0](values);
+}
+
+double NativeExpression::derivative(const std::string& var, const double* values) const {
+    return function(var)(values);
+}
+
+NativeExpression::Function NativeExpression::function() const {
+    return functions[0];
+}
+
+NativeExpression::Function NativeExpression::function(const std::string& var) const {
+    for (size_t i = 0; i < derivativeNames.size(); i++) {
+        if (derivativeNames[i] == var) return functions[i + 1];
+    }
+    throw std::invalid_argument("No derivative by '" + var + "' was generated.");
+}
+
+const std::vector<std::string>& NativeExpression::variables() const {
+    return variableNames;
+}
+
+const std::string& NativeExpression::library() const {
+    return path;
+}
+
+bool NativeExpression::cached() const {
+    return reused;
+}
\ No newline at end of file
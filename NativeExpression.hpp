@@ -0,0 +1,43 @@
+#ifndef NATIVE_EXPRESSION_HPP
+#define NATIVE_EXPRESSION_HPP
+
+#include "Expression.hpp"
+#include <vector>
+#include <string>
+
+class NativeExpression {
+public:
+    typedef double (*Function)(const double*);
+
+    explicit NativeExpression(const Expression<double>& expr, const std::vector<std::string>& derivatives = {});
+    NativeExpression(const Expression<double>& expr, const std::vector<std::string>& derivatives,
+                     const std::vector<std::string>& order);
+    ~NativeExpression();
+    NativeExpression(const NativeExpression&) = delete;
+    NativeExpression& operator=(const NativeExpression&) = delete;
+
+    double evaluate(const double* values) const;
+    double derivative(const std::string& var, const double* values) const;
+    Function function() const;
+    Function function(const std::string& var) const;
+
+    const std::vector<std::string>& variables() const;
+    const std::string& library() const;
+    bool cached() const;
+
+    static std::string source(const Expression<double>& expr, const std::vector<std::string>& derivatives,
+                              const std::vector<std::string>& order);
+    static std::string cacheDirectory();
+
+private:
+    void load(const std::string& code);
+
+    std::vector<std::string> variableNames;
+    std::vector<std::string> derivativeNames;
+    std::vector<Function> functions;
+    std::string path;
+    void* handle;
+    bool reused;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "NewtonSolver.hpp"
+#include <cmath>
+#include <limits>
+
+NewtonSolver::NewtonSolver(const Expression<double>& f, const std::string& var, bool minimize)
+    : gradient(f.differentiate(var)),
+      curvature(minimize ? gradient.differentiate(var) : gradient),
+      objective(f, {var}),
+      residual(minimize ? gradient : f, {var}),
+      slope(curvature, {var}),
+      minimize(minimize) {
+}
+
+void NewtonSolver::evaluate(const CompiledExpression<double>& expr, const std::vector<double>& xs, std::vector<double>& out) const {
+    const double* columns[] = {xs.data()};
+    out.resize(xs.size());
+    expr.evaluateBatch(columns, out.data(), xs.size());
+}
+
+std::vector<NewtonSolver::Result> NewtonSolver::solve(const std::vector<double>& starts, size_t maxIterations, double tolerance) const {
+    const int maxHalvings = 30;
+    std::vector<Result> results;
+    results.reserve(starts.size());
+    for (double start : starts) results.push_back({start, start, std::numeric_limits<double>::quiet_NaN(), 0, false});
+
+    std::vector<size_t> active(starts.size());
+    for (size_t i = 0; i < active.size(); i++) active[i] = i;
+    std::vector<double> xs, g, d, merit, steps, trial, points, trialMerit;
+    std::vector<size_t> retry, next;
+    std::vector<char> stalled;
+    for (size_t iteration = 0; iteration < maxIterations && !active.empty(); iteration++) {
+        xs.resize(active.size());
+        for (size_t k = 0; k < active.size(); k++) xs[k] = results[active[k]].x;
+        evaluate(residual, xs, g);
+        evaluate(slope, xs, d);
+        if (minimize) evaluate(objective, xs, merit);
+        else merit.resize(active.size());
+
+        next.clear();
+        steps.clear();
+        for (size_t k = 0; k < active.size(); k++) {
+            Result& r = results[active[k]];
+            r.residual = std::abs(g[k]);
+            if (!std::isfinite(g[k])) continue;
+            if (r.residual <= tolerance) {
+                r.converged = true;
+                continue;
+            }
+            bool usable = d[k] != 0.0 && std::isfinite(d[k]);
+            if (!usable && !minimize) continue;
+            double step = !usable ? g[k] : minimize ? g[k] / std::abs(d[k]) : g[k] / d[k];
+            if (std::abs(step) <= tolerance * (1.0 + std::abs(xs[k]))) {
+                r.x = xs[k] - step;
+                r.iterations++;
+                r.converged = true;
+                continue;
+            }
+            xs[next.size()] = xs[k];
+            merit[next.size()] = minimize ? merit[k] : r.residual;
+            steps.push_back(step);
+            next.push_back(active[k]);
+        }
+        active.swap(next);
+        xs.resize(active.size());
+
+        trial.resize(active.size());
+        retry.resize(active.size());
+        stalled.assign(active.size(), 0);
+        for (size_t k = 0; k < active.size(); k++) {
+            trial[k] = xs[k] - steps[k];
+            retry[k] = k;
+        }
+        for (int halving = 0; !retry.empty(); halving++) {
+            points.resize(retry.size());
+            for (size_t j = 0; j < retry.size(); j++) points[j] = trial[retry[j]];
+            evaluate(minimize ? objective : residual, points, trialMerit);
+            size_t kept = 0;
+            for (size_t j = 0; j < retry.size(); j++) {
+                size_t k = retry[j];
+                bool improved = minimize ? trialMerit[j] <= merit[k] + 4 * std::numeric_limits<double>::epsilon() * std::abs(merit[k])
+                                         : std::abs(trialMerit[j]) < merit[k];
+                if (improved) continue;
+                if (halving == maxHalvings) {
+                    stalled[k] = 1;
+                    continue;
+                }
+                steps[k] *= 0.5;
+                trial[k] = xs[k] - steps[k];
+                retry[kept++] = k;
+            }
+            retry.resize(kept);
+        }
+
+        next.clear();
+        for (size_t k = 0; k < active.size(); k++) {
+            if (stalled[k]) continue;
+            Result& r = results[active[k]];
+            r.x = trial[k];
+            r.iterations++;
+            next.push_back(active[k]);
+        }
+        active.swap(next);
+    }
+
+    xs.resize(results.size());
+    for (size_t i = 0; i < results.size(); i++) xs[i] = results[i].x;
+    evaluate(residual, xs, g);
+    for (size_t i = 0; i < results.size(); i++) {
+        results[i].residual = std::abs(g[i]);
+        if (!std::isfinite(results[i].x) || !std::isfinite(g[i])) results[i].converged = false;
+    }
+    return results;
+}
+
+bool NewtonSolver::minimizing() const {
+    return minimize;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef NEWTON_SOLVER_HPP
+#define NEWTON_SOLVER_HPP
+
+#include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include <vector>
+#include <string>
+
+// Damped Newton iteration in one variable, run for many starting points at
+// once. Root finding iterates on f and f', minimization on f' and f''. Every
+// pass evaluates the still-active starts through the batch evaluator, and a
+// start leaves the batch as soon as it converges or fails.
+class NewtonSolver {
+public:
+    struct Result {
+        double start;
+        double x;
+        double residual;
+        size_t iterations;
+        bool converged;
+    };
+
+    NewtonSolver(const Expression<double>& f, const std::string& var, bool minimize = false);
+
+    std::vector<Result> solve(const std::vector<double>& starts, size_t maxIterations = 50, double tolerance = 1e-12) const;
+    bool minimizing() const;
+
+private:
+    void evaluate(const CompiledExpression<double>& expr, const std::vector<double>& xs, std::vector<double>& out) const;
+
+    Expression<double> gradient;
+    Expression<double> curvature;
+    CompiledExpression<double> objective;
+    CompiledExpression<double> residual;
+    CompiledExpression<double> slope;
+    bool minimize;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "Polynomial.hpp"
+#include "SimdMath.hpp"
+#include "SymbolTable.hpp"
+#include <map>
+#include <unordered_set>
+
+namespace {
+
+template <typename T>
+bool integerExponent(T value, unsigned int limit, unsigned int& exponent) {
+    double re = std::real(value);
+    if (std::imag(value) != 0.0 || !(re >= 0.0) || re > limit || re != std::floor(re)) return false;
+    exponent = static_cast<unsigned int>(re);
+    return true;
+}
+
+template <typename V, typename T>
+V broadcast(T value) {
+    if constexpr (std::is_same_v<V, simd::Double>) return simd::splat(value);
+    else return V(value);
+}
+
+// Estrin pairs neighbouring coefficients with x, then pairs the results with
+// x^2, x^4, ... so the dependency chain is log2(degree) long instead of degree.
+template <typename V, typename T>
+V univariate(const T* c, unsigned int degree, V x, unsigned int estrinDegree) {
+    if (degree < estrinDegree) {
+        V acc = broadcast<V>(c[degree]);
+        for (unsigned int k = degree; k-- > 0;) acc = acc * x + broadcast<V>(c[k]);
+        return acc;
+    }
+    V buffer[Polynomial<T>::maxDegree / 2 + 1];
+    unsigned int n = degree + 1;
+    for (unsigned int i = 0; 2 * i < n; i++) {
+        buffer[i] = 2 * i + 1 < n ? broadcast<V>(c[2 * i + 1]) * x + broadcast<V>(c[2 * i]) : broadcast<V>(c[2 * i]);
+    }
+    n = (n + 1) / 2;
+    for (V power = x * x; n > 1; power = power * power) {
+        for (unsigned int i = 0; 2 * i < n; i++) {
+            buffer[i] = 2 * i + 1 < n ? buffer[2 * i + 1] * power + buffer[2 * i] : buffer[2 * i];
+        }
+        n = (n + 1) / 2;
+    }
+    return buffer[0];
+}
+
+}
+
+template <typename T>
+Polynomial<T>::Polynomial() : coeffs{T(0)} {
+}
+
+template <typename T>
+std::optional<Polynomial<T>> Polynomial<T>::fromExpression(const Expression<T>& expr) {
+    Shapes shapes;
+    classify(*expr.arena, expr.id, shapes);
+    if (shapes.at(expr.id).kind == Shape::OTHER) return std::nullopt;
+    return dense(expand(*expr.arena, expr.id));
+}
+
+// Only maximal candidates are expanded: once a subtree is fused nothing below
+// it is looked at, and a candidate with no power of 2 or more cannot contain
+// one either.
+template <typename T>
+std::unordered_map<unsigned int, Polynomial<T>> Polynomial<T>::find(const ExpressionArena<T>& arena, unsigned int root) {
+    typedef ExpressionArena<T> Arena;
+    Shapes shapes;
+    classify(arena, root, shapes);
+
+    std::unordered_map<unsigned int, Polynomial> found;
+    std::unordered_set<unsigned int> visited;
+    std::vector<std::pair<unsigned int, bool>> pending{{root, true}};
+    while (!pending.empty()) {
+        auto [id, candidate] = pending.back();
+        pending.pop_back();
+        if (!visited.insert(id).second) continue;
+        const typename Arena::Node& n = arena.node(id);
+        if (n.type != Arena::OPERATION && n.type != Arena::FUNCTION) continue;
+        const Shape& shape = shapes.at(id);
+        if (shape.kind != Shape::OTHER && n.type == Arena::OPERATION) {
+            if (std::none_of(shape.degrees, shape.degrees + shape.count, [](unsigned int d) { return d >= 2; })) continue;
+            if (candidate) {
+                std::optional<Polynomial> p = dense(expand(arena, id));
+                if (p && std::any_of(p->degrees.begin(), p->degrees.end(), [](unsigned int d) { return d >= 2; })) {
+                    found.emplace(id, std::move(*p));
+                    continue;
+                }
+            }
+            // A rejected sum is not retried piecewise; only its monomials are.
+            if (shape.kind == Shape::SUM) {
+                pending.push_back({n.right, shapes.at(n.right).kind == Shape::MONOMIAL});
+                pending.push_back({n.left, shapes.at(n.left).kind == Shape::MONOMIAL});
+                continue;
+            }
+        }
+        if (n.type == Arena::OPERATION) pending.push_back({n.right, true});
+        pending.push_back({n.left, true});
+    }
+    return found;
+}
+
+template <typename T>
+void Polynomial<T>::classify(const ExpressionArena<T>& arena, unsigned int root, Shapes& shapes) {
+    typedef ExpressionArena<T> Arena;
+    std::vector<std::pair<unsigned int, bool>> pending{{root, false}};
+    while (!pending.empty()) {
+        auto [id, expanded] = pending.back();
+        if (shapes.count(id)) {
+            pending.pop_back();
+            continue;
+        }
+        const typename Arena::Node& n = arena.node(id);
+        if ((n.type == Arena::OPERATION || n.type == Arena::FUNCTION) && !expanded) {
+            pending.back().second = true;
+            if (n.type == Arena::OPERATION) pending.push_back({n.right, false});
+            pending.push_back({n.left, false});
+            continue;
+        }
+        pending.pop_back();
+        Shape shape{Shape::OTHER, 0, {}, {}, 1};
+        if (n.type == Arena::CONSTANT) {
+            shape.kind = Shape::MONOMIAL;
+        } else if (n.type == Arena::VARIABLE) {
+            shape = Shape{Shape::MONOMIAL, 1, {n.symbol}, {1}, 1};
+        } else if (n.type == Arena::OPERATION) {
+            const Shape& l = shapes.at(n.left);
+            const Shape& r = shapes.at(n.right);
+            const typename Arena::Node& right = arena.node(n.right);
+            unsigned int exponent = 0;
+            // Only sums of monomials qualify: multiplying out (x - a) ^ n or a
+            // product of sums would cancel catastrophically near the roots.
+            switch (n.operation) {
+            case '+': case '-':
+                if (l.kind == Shape::OTHER || r.kind == Shape::OTHER) break;
+                shape = l;
+                shape.kind = merge(shape, r, false) ? Shape::SUM : Shape::OTHER;
+                break;
+            case '*':
+                if (l.kind != Shape::MONOMIAL || r.kind != Shape::MONOMIAL) break;
+                shape = l;
+                if (!merge(shape, r, true)) shape.kind = Shape::OTHER;
+                break;
+            case '/':
+                if (l.kind != Shape::MONOMIAL || right.type != Arena::CONSTANT || right.value == T(0)) break;
+                shape = l;
+                shape.leaves++;
+                break;
+            case '^':
+                if (l.kind != Shape::MONOMIAL || right.type != Arena::CONSTANT
+                    || !integerExponent(right.value, maxDegree, exponent)) break;
+                shape = l;
+                for (unsigned char v = 0; v < shape.count; v++) shape.degrees[v] *= exponent;
+                shape.leaves++;
+                if (!merge(shape, Shape{Shape::MONOMIAL, 0, {}, {}, 0}, true)) shape.kind = Shape::OTHER;
+                break;
+            default: break;
+            }
+        }
+        shapes.emplace(id, shape);
+    }
+}
+
+// Folds the variables of from into into, adding powers for a product and
+// keeping the highest for a sum. False once the result could not be fused.
+template <typename T>
+bool Polynomial<T>::merge(Shape& into, const Shape& from, bool product) {
+    for (unsigned char i = 0; i < from.count; i++) {
+        unsigned char v = 0;
+        while (v < into.count && into.symbols[v] != from.symbols[i]) v++;
+        if (v == into.count) {
+            if (into.count == maxVariables) return false;
+            into.symbols[into.count] = from.symbols[i];
+            into.degrees[into.count++] = 0;
+        }
+        into.degrees[v] = product ? into.degrees[v] + from.degrees[i] : std::max(into.degrees[v], from.degrees[i]);
+    }
+    into.leaves += from.leaves;
+    if (into.leaves > maxLeaves) return false;
+    size_t coefficients = 1;
+    for (unsigned char v = 0; v < into.count; v++) {
+        if (into.degrees[v] > maxDegree) return false;
+        coefficients *= into.degrees[v] + 1;
+        if (coefficients > maxCoefficients) return false;
+    }
+    return true;
+}
+
+// Walks the sum from the top, carrying the sign, and adds each monomial into
+// one ordered map so no intermediate sums are materialized.
+template <typename T>
+typename Polynomial<T>::Terms Polynomial<T>::expand(const ExpressionArena<T>& arena, unsigned int root) {
+    typedef ExpressionArena<T> Arena;
+    std::map<Monomial, T> sum;
+    std::vector<std::pair<unsigned int, bool>> pending{{root, false}};
+    while (!pending.empty()) {
+        auto [id, negated] = pending.back();
+        pending.pop_back();
+        const typename Arena::Node& n = arena.node(id);
+        if (n.type == Arena::OPERATION && (n.operation == '+' || n.operation == '-')) {
+            pending.push_back({n.right, negated != (n.operation == '-')});
+            pending.push_back({n.left, negated});
+            continue;
+        }
+        std::pair<Monomial, T> term = monomial(arena, id);
+        T& value = sum[term.first];
+        value = negated ? value - term.second : value + term.second;
+    }
+    Terms terms;
+    for (auto& [m, value] : sum) {
+        if (value != T(0)) terms.push_back({m, value});
+    }
+    return terms;
+}
+
+template <typename T>
+std::pair<typename Polynomial<T>::Monomial, T> Polynomial<T>::monomial(const ExpressionArena<T>& arena, unsigned int root) {
+    typedef ExpressionArena<T> Arena;
+    std::vector<std::pair<Monomial, T>> values;
+    std::vector<std::pair<unsigned int, bool>> pending{{root, false}};
+    while (!pending.empty()) {
+        auto [id, expanded] = pending.back();
+        const typename Arena::Node& n = arena.node(id);
+        if (n.type == Arena::OPERATION && !expanded) {
+            pending.back().second = true;
+            if (n.operation == '*') pending.push_back({n.right, false});
+            pending.push_back({n.left, false});
+            continue;
+        }
+        pending.pop_back();
+        if (n.type == Arena::CONSTANT) {
+            values.push_back({Monomial(), n.value});
+        } else if (n.type == Arena::VARIABLE) {
+            values.push_back({Monomial{{n.symbol, 1}}, T(1)});
+        } else if (n.operation == '*') {
+            std::pair<Monomial, T> r = std::move(values.back());
+            values.pop_back();
+            std::pair<Monomial, T>& l = values.back();
+            for (const auto& factor : r.first) {
+                auto it = std::lower_bound(l.first.begin(), l.first.end(), factor,
+                                           [](const auto& a, const auto& b) { return a.first < b.first; });
+                if (it != l.first.end() && it->first == factor.first) it->second += factor.second;
+                else l.first.insert(it, factor);
+            }
+            l.second = l.second * r.second;
+        } else if (n.operation == '/') {
+            values.back().second = values.back().second / arena.node(n.right).value;
+        } else {
+            unsigned int exponent = 0;
+            integerExponent(arena.node(n.right).value, maxDegree, exponent);
+            std::pair<Monomial, T>& base = values.back();
+            for (auto& factor : base.first) factor.second *= exponent;
+            T power(1);
+            for (unsigned int k = 0; k < exponent; k++) power = power * base.second;
+            base.second = power;
+            base.first.erase(std::remove_if(base.first.begin(), base.first.end(), [](const auto& f) { return f.second == 0; }),
+                             base.first.end());
+        }
+    }
+    return values.back();
+}
+
+template <typename T>
+std::optional<Polynomial<T>> Polynomial<T>::dense(const Terms& terms) {
+    std::vector<unsigned int> symbols;
+    for (const auto& term : terms) {
+        for (const auto& factor : term.first) symbols.push_back(factor.first);
+    }
+    std::sort(symbols.begin(), symbols.end());
+    symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+    if (symbols.size() > maxVariables) return std::nullopt;
+    std::vector<unsigned int> highest(symbols.size(), 0);
+    for (const auto& term : terms) {
+        for (const auto& [symbol, power] : term.first) {
+            size_t v = std::lower_bound(symbols.begin(), symbols.end(), symbol) - symbols.begin();
+            highest[v] = std::max(highest[v], power);
+        }
+    }
+    std::vector<size_t> order(symbols.size());
+    for (size_t v = 0; v < order.size(); v++) order[v] = v;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (highest[a] != highest[b]) return highest[a] < highest[b];
+        return SymbolTable::name(symbols[a]) < SymbolTable::name(symbols[b]);
+    });
+
+    Polynomial p;
+    std::vector<unsigned int> sorted;
+    for (size_t v : order) {
+        sorted.push_back(symbols[v]);
+        p.degrees.push_back(highest[v]);
+    }
+    symbols.swap(sorted);
+    size_t count = 1;
+    p.strides.assign(symbols.size(), 1);
+    for (size_t v = symbols.size(); v-- > 0;) {
+        p.strides[v] = count;
+        count *= p.degrees[v] + 1;
+        if (count > maxCoefficients) return std::nullopt;
+    }
+    if (count > maxSparsity * (terms.size() + 1)) return std::nullopt;
+    for (unsigned int symbol : symbols) p.names.push_back(SymbolTable::name(symbol));
+    p.coeffs.assign(count, T(0));
+    for (const auto& term : terms) {
+        size_t index = 0;
+        for (const auto& [symbol, power] : term.first) {
+            index += power * p.strides[std::find(symbols.begin(), symbols.end(), symbol) - symbols.begin()];
+        }
+        p.coeffs[index] = term.second;
+    }
+    return p;
+}
+
+template <typename T>
+template <typename V>
+V Polynomial<T>::evaluateLevel(const V* x, size_t level, size_t offset) const {
+    size_t last = degrees.size() - 1;
+    if (level == last) return univariate(coeffs.data() + offset, degrees[last], x[last], estrinDegree);
+    V acc = evaluateLevel(x, level + 1, offset + degrees[level] * strides[level]);
+    for (unsigned int k = degrees[level]; k-- > 0;) acc = acc * x[level] + evaluateLevel(x, level + 1, offset + k * strides[level]);
+    return acc;
+}
+
+template <typename T>
+T Polynomial<T>::evaluate(const T* values) const {
+    if (degrees.empty()) return coeffs[0];
+    return evaluateLevel(values, 0, 0);
+}
+
+template <typename T>
+void Polynomial<T>::evaluateBatch(const T* const* columns, T* out, size_t count) const {
+    if (degrees.empty()) {
+        std::fill(out, out + count, coeffs[0]);
+        return;
+    }
+    if constexpr (std::is_same_v<T, double>) {
+        simd::Double x[maxVariables];
+        size_t full = count / simd::width * simd::width;
+        for (size_t i = 0; i < full; i += simd::width) {
+            for (size_t v = 0; v < degrees.size(); v++) x[v] = simd::load(columns[v] + i);
+            simd::store(out + i, evaluateLevel(x, 0, 0));
+        }
+        if (full == count) return;
+        double tail[simd::width] = {};
+        for (size_t v = 0; v < degrees.size(); v++) {
+            std::copy(columns[v] + full, columns[v] + count, tail);
+            x[v] = simd::load(tail);
+        }
+        simd::store(tail, evaluateLevel(x, 0, 0));
+        std::copy(tail, tail + (count - full), out + full);
+    } else {
+        T x[maxVariables];
+        for (size_t i = 0; i < count; i++) {
+            for (size_t v = 0; v < degrees.size(); v++) x[v] = columns[v][i];
+            out[i] = evaluateLevel(x, 0, 0);
+        }
+    }
+}
+
+template <typename T>
+Polynomial<T> Polynomial<T>::derivative(const std::string& var) const {
+    Polynomial result = *this;
+    std::fill(result.coeffs.begin(), result.coeffs.end(), T(0));
+    size_t v = std::find(names.begin(), names.end(), var) - names.begin();
+    if (v == names.size()) return result;
+    for (size_t i = 0; i < coeffs.size(); i++) {
+        size_t power = i / strides[v] % (degrees[v] + 1);
+        if (power) result.coeffs[i - strides[v]] = T(static_cast<double>(power)) * coeffs[i];
+    }
+    return result;
+}
+
+template <typename T>
+Expression<T> Polynomial<T>::toExpression() const {
+    std::optional<Expression<T>> sum;
+    for (size_t i = coeffs.size(); i-- > 0;) {
+        if (coeffs[i] == T(0)) continue;
+        std::optional<Expression<T>> term;
+        for (size_t v = 0; v < names.size(); v++) {
+            size_t power = i / strides[v] % (degrees[v] + 1);
+            if (!power) continue;
+            Expression<T> factor = power == 1 ? Expression<T>(names[v])
+                                              : Expression<T>(names[v]) ^ Expression<T>(T(static_cast<double>(power)));
+            term = term ? std::move(*term) * factor : factor;
+        }
+        if (!term) term = Expression<T>(coeffs[i]);
+        else if (coeffs[i] != T(1)) term = Expression<T>(coeffs[i]) * std::move(*term);
+        sum = sum ? std::move(*sum) + *term : *term;
+    }
+    return sum ? *sum : Expression<T>(T(0));
+}
+
+template <typename T>
+const std::vector<std::string>& Polynomial<T>::variables() const {
+    return names;
+}
+
+template <typename T>
+unsigned int Polynomial<T>::degree(const std::string& var) const {
+    size_t v = std::find(names.begin(), names.end(), var) - names.begin();
+    return v == names.size() ? 0 : degrees[v];
+}
+
+template <typename T>
+const std::vector<T>& Polynomial<T>::coefficients() const {
+    return coeffs;
+}
+
+template class Polynomial<double>;
+template class Polynomial<std::complex<double>>;
\ No newline at end of file
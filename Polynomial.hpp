@@ -0,0 +1,77 @@
+#ifndef POLYNOMIAL_HPP
+#define POLYNOMIAL_HPP
+
+#include "Expression.hpp"
+#include <vector>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+// Dense coefficient form of a polynomial in up to maxVariables variables,
+// recognized only where the expression is already a sum of c * x^k * y^j
+// terms; factored forms stay on the generic path, which is more accurate.
+// Layouts with more than maxSparsity coefficients per monomial stay generic
+// too, since the tape beats Horner over mostly-zero coefficients.
+// Coefficients sit in one array indexed by the exponents, the last variable
+// varying fastest, so evaluation is Horner in every outer variable around a
+// contiguous univariate kernel (Horner for low degree, Estrin from
+// estrinDegree up). variables() is ordered by degree so the innermost kernel
+// gets the highest one. Integer powers never reach std::pow.
+template <typename T>
+class Polynomial {
+public:
+    static constexpr size_t maxVariables = 8;
+    static constexpr unsigned int maxDegree = 64;
+    static constexpr size_t maxCoefficients = 4096;
+    static constexpr size_t maxLeaves = 4 * maxCoefficients;
+    static constexpr size_t maxSparsity = 4;
+    static constexpr unsigned int estrinDegree = 8;
+
+    Polynomial();
+
+    static std::optional<Polynomial> fromExpression(const Expression<T>& expr);
+    static std::unordered_map<unsigned int, Polynomial> find(const ExpressionArena<T>& arena, unsigned int root);
+
+    T evaluate(const T* values) const;
+    void evaluateBatch(const T* const* columns, T* out, size_t count) const;
+    Polynomial derivative(const std::string& var) const;
+    Expression<T> toExpression() const;
+
+    const std::vector<std::string>& variables() const;
+    unsigned int degree(const std::string& var) const;
+    const std::vector<T>& coefficients() const;
+
+private:
+    typedef std::vector<std::pair<unsigned int, unsigned int>> Monomial;
+    typedef std::vector<std::pair<Monomial, T>> Terms;
+
+    // What a node would expand to, learned without expanding it: one
+    // monomial, a sum of monomials, or neither. Keeps the highest power of
+    // each variable and how many leaves an expansion would visit, so
+    // oversized candidates are dropped before any terms are built.
+    struct Shape {
+        enum Kind : unsigned char { OTHER, MONOMIAL, SUM };
+        Kind kind;
+        unsigned char count;
+        unsigned int symbols[maxVariables];
+        unsigned int degrees[maxVariables];
+        size_t leaves;
+    };
+    typedef std::unordered_map<unsigned int, Shape> Shapes;
+
+    static void classify(const ExpressionArena<T>& arena, unsigned int root, Shapes& shapes);
+    static bool merge(Shape& into, const Shape& from, bool product);
+    static Terms expand(const ExpressionArena<T>& arena, unsigned int root);
+    static std::pair<Monomial, T> monomial(const ExpressionArena<T>& arena, unsigned int root);
+    static std::optional<Polynomial> dense(const Terms& terms);
+
+    template <typename V>
+    V evaluateLevel(const V* x, size_t level, size_t offset) const;
+
+    std::vector<std::string> names;
+    std::vector<unsigned int> degrees;
+    std::vector<size_t> strides;
+    std::vector<T> coeffs;
+};
+
+#endif
\ No newline at end of file
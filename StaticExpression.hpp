@@ -0,0 +1,385 @@
+#ifndef STATIC_EXPRESSION_HPP
+#define STATIC_EXPRESSION_HPP
+
+#include "Expression.hpp"
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+// Compile-time counterpart of Expression<T> for formulas known at build time.
+// Every formula is a type built from Var<'x'>, numbers, sin/cos/ln/exp and
+// + - * / ^; evaluate() inlines to straight-line code and is constexpr where
+// the operations are. differentiate<'x'>() returns another formula type, with
+// zeros and ones folded away while the type is built. Integer exponents
+// written as Int<N> or with the _c suffix (x ^ 3_c) become multiplications.
+// toExpression<T>() rebuilds the same formula as a runtime Expression<T>.
+namespace ct {
+
+struct Node {};
+
+template <typename A>
+constexpr bool isNode = std::is_base_of_v<Node, A>;
+
+template <typename T, char... Names>
+struct Values {
+    typedef T Value;
+    T values[sizeof...(Names)];
+
+    template <char Name>
+    static constexpr size_t slot() {
+        constexpr char names[] = {Names...};
+        size_t i = 0;
+        while (i < sizeof...(Names) && names[i] != Name) i++;
+        return i;
+    }
+
+    template <char Name>
+    constexpr T get() const {
+        static_assert(slot<Name>() < sizeof...(Names), "Variable is not bound");
+        return values[slot<Name>()];
+    }
+};
+
+template <char... Names, typename... Args>
+constexpr auto values(Args... args) {
+    typedef std::common_type_t<Args...> T;
+    return Values<T, Names...>{{static_cast<T>(args)...}};
+}
+
+template <char Name>
+struct Var : Node {
+    template <typename Env>
+    constexpr typename Env::Value evaluate(const Env& env) const {
+        return env.template get<Name>();
+    }
+
+    template <typename T>
+    Expression<T> toExpression() const {
+        return Expression<T>(std::string(1, Name));
+    }
+};
+
+template <int N>
+struct Int : Node {
+    static constexpr int value = N;
+
+    template <typename Env>
+    constexpr typename Env::Value evaluate(const Env&) const {
+        return typename Env::Value(N);
+    }
+
+    template <typename T>
+    Expression<T> toExpression() const {
+        return Expression<T>(T(N));
+    }
+};
+
+struct Constant : Node {
+    double value;
+
+    constexpr explicit Constant(double value) : value(value) {}
+
+    template <typename Env>
+    constexpr typename Env::Value evaluate(const Env&) const {
+        return typename Env::Value(value);
+    }
+
+    template <typename T>
+    Expression<T> toExpression() const {
+        return Expression<T>(T(value));
+    }
+};
+
+template <typename A>
+struct IsInt : std::false_type {};
+
+template <int N>
+struct IsInt<Int<N>> : std::true_type {};
+
+template <typename A>
+constexpr bool isInt = IsInt<A>::value;
+
+template <typename A>
+constexpr bool isZero = std::is_same_v<A, Int<0>>;
+
+template <typename A>
+constexpr bool isOne = std::is_same_v<A, Int<1>>;
+
+template <typename V>
+constexpr V power(V base, unsigned int n) {
+    V result = V(1);
+    for (; n; n >>= 1) {
+        if (n & 1) result = result * base;
+        base = base * base;
+    }
+    return result;
+}
+
+template <typename L, typename R, char Op>
+struct Binary : Node {
+    L left;
+    R right;
+
+    constexpr Binary(L left, R right) : left(left), right(right) {}
+
+    template <typename Env>
+    constexpr typename Env::Value evaluate(const Env& env) const {
+        typedef typename Env::Value V;
+        if constexpr (Op == '^' && isInt<R>) {
+            V p = power(left.evaluate(env), R::value < 0 ? -R::value : R::value);
+            return R::value < 0 ? V(1) / p : p;
+        } else {
+            V a = left.evaluate(env);
+            V b = right.evaluate(env);
+            if constexpr (Op == '+') return a + b;
+            else if constexpr (Op == '-') return a - b;
+            else if constexpr (Op == '*') return a * b;
+            else if constexpr (Op == '/') return a / b;
+            else {
+                using std::pow;
+                return pow(a, b);
+            }
+        }
+    }
+
+    template <typename T>
+    Expression<T> toExpression() const {
+        Expression<T> a = left.template toExpression<T>();
+        Expression<T> b = right.template toExpression<T>();
+        if constexpr (Op == '+') return a + b;
+        else if constexpr (Op == '-') return a - b;
+        else if constexpr (Op == '*') return a * b;
+        else if constexpr (Op == '/') return a / b;
+        else return a ^ b;
+    }
+};
+
+template <typename L, typename R>
+using Add = Binary<L, R, '+'>;
+template <typename L, typename R>
+using Sub = Binary<L, R, '-'>;
+template <typename L, typename R>
+using Mul = Binary<L, R, '*'>;
+template <typename L, typename R>
+using Div = Binary<L, R, '/'>;
+template <typename L, typename R>
+using Pow = Binary<L, R, '^'>;
+
+enum FunctionCode { SIN, COS, LN, EXP };
+
+template <typename A, FunctionCode F>
+struct Function : Node {
+    A arg;
+
+    constexpr explicit Function(A arg) : arg(arg) {}
+
+    template <typename Env>
+    constexpr typename Env::Value evaluate(const Env& env) const {
+        using std::sin;
+        using std::cos;
+        using std::log;
+        using std::exp;
+        if constexpr (F == SIN) return sin(arg.evaluate(env));
+        else if constexpr (F == COS) return cos(arg.evaluate(env));
+        else if constexpr (F == LN) return log(arg.evaluate(env));
+        else return exp(arg.evaluate(env));
+    }
+
+    template <typename T>
+    Expression<T> toExpression() const {
+        Expression<T> a = arg.template toExpression<T>();
+        if constexpr (F == SIN) return Expression<T>::sin(a);
+        else if constexpr (F == COS) return Expression<T>::cos(a);
+        else if constexpr (F == LN) return Expression<T>::ln(a);
+        else return Expression<T>::exp(a);
+    }
+};
+
+template <typename A>
+using Sin = Function<A, SIN>;
+template <typename A>
+using Cos = Function<A, COS>;
+template <typename A>
+using Ln = Function<A, LN>;
+template <typename A>
+using Exp = Function<A, EXP>;
+
+template <typename A>
+constexpr auto wrap(A a) {
+    if constexpr (isNode<A>) return a;
+    else return Constant(static_cast<double>(a));
+}
+
+// Builders used by the operators and by differentiate(): they fold integer
+// constants and drop additions of zero and multiplications by zero or one.
+template <typename L, typename R>
+constexpr auto add(L l, R r) {
+    if constexpr (isInt<L> && isInt<R>) return Int<L::value + R::value>{};
+    else if constexpr (isZero<L>) return r;
+    else if constexpr (isZero<R>) return l;
+    else return Add<L, R>(l, r);
+}
+
+template <typename L, typename R>
+constexpr auto sub(L l, R r) {
+    if constexpr (isInt<L> && isInt<R>) return Int<L::value - R::value>{};
+    else if constexpr (isZero<R>) return l;
+    else return Sub<L, R>(l, r);
+}
+
+template <typename L, typename R>
+constexpr auto mul(L l, R r) {
+    if constexpr (isInt<L> && isInt<R>) return Int<L::value * R::value>{};
+    else if constexpr (isZero<L> || isZero<R>) return Int<0>{};
+    else if constexpr (isOne<L>) return r;
+    else if constexpr (isOne<R>) return l;
+    else return Mul<L, R>(l, r);
+}
+
+template <typename L, typename R>
+constexpr auto div(L l, R r) {
+    if constexpr (isZero<L>) return Int<0>{};
+    else if constexpr (isOne<R>) return l;
+    else return Div<L, R>(l, r);
+}
+
+template <typename L, typename R>
+constexpr auto pow(L l, R r) {
+    if constexpr (isZero<R>) return Int<1>{};
+    else if constexpr (isOne<R>) return l;
+    else return Pow<L, R>(l, r);
+}
+
+template <typename A, typename = std::enable_if_t<isNode<A>>>
+constexpr auto sin(A a) {
+    return Sin<A>(a);
+}
+
+template <typename A, typename = std::enable_if_t<isNode<A>>>
+constexpr auto cos(A a) {
+    return Cos<A>(a);
+}
+
+template <typename A, typename = std::enable_if_t<isNode<A>>>
+constexpr auto ln(A a) {
+    return Ln<A>(a);
+}
+
+template <typename A, typename = std::enable_if_t<isNode<A>>>
+constexpr auto exp(A a) {
+    return Exp<A>(a);
+}
+
+template <typename L, typename R>
+constexpr bool operands = (isNode<L> || isNode<R>) && (isNode<L> || std::is_arithmetic_v<L>) && (isNode<R> || std::is_arithmetic_v<R>);
+
+template <typename L, typename R, typename = std::enable_if_t<operands<L, R>>>
+constexpr auto operator+(L l, R r) {
+    return add(wrap(l), wrap(r));
+}
+
+template <typename L, typename R, typename = std::enable_if_t<operands<L, R>>>
+constexpr auto operator-(L l, R r) {
+    return sub(wrap(l), wrap(r));
+}
+
+template <typename L, typename R, typename = std::enable_if_t<operands<L, R>>>
+constexpr auto operator*(L l, R r) {
+    return mul(wrap(l), wrap(r));
+}
+
+template <typename L, typename R, typename = std::enable_if_t<operands<L, R>>>
+constexpr auto operator/(L l, R r) {
+    return div(wrap(l), wrap(r));
+}
+
+template <typename L, typename R, typename = std::enable_if_t<operands<L, R>>>
+constexpr auto operator^(L l, R r) {
+    return pow(wrap(l), wrap(r));
+}
+
+template <typename A, typename = std::enable_if_t<isNode<A>>>
+constexpr auto operator-(A a) {
+    return mul(Int<-1>{}, a);
+}
+
+constexpr int digits(const char* text, int value = 0) {
+    return *text ? digits(text + 1, value * 10 + (*text - '0')) : value;
+}
+
+template <char... Digits>
+constexpr auto operator""_c() {
+    constexpr char text[] = {Digits..., '\0'};
+    return Int<digits(text)>{};
+}
+
+template <char X, char Name>
+constexpr auto differentiate(Var<Name>) {
+    return Int<Name == X ? 1 : 0>{};
+}
+
+template <char X, int N>
+constexpr auto differentiate(Int<N>) {
+    return Int<0>{};
+}
+
+template <char X>
+constexpr auto differentiate(Constant) {
+    return Int<0>{};
+}
+
+template <char X, typename L, typename R>
+constexpr auto differentiate(Add<L, R> e) {
+    return add(differentiate<X>(e.left), differentiate<X>(e.right));
+}
+
+template <char X, typename L, typename R>
+constexpr auto differentiate(Sub<L, R> e) {
+    return sub(differentiate<X>(e.left), differentiate<X>(e.right));
+}
+
+template <char X, typename L, typename R>
+constexpr auto differentiate(Mul<L, R> e) {
+    return add(mul(differentiate<X>(e.left), e.right), mul(e.left, differentiate<X>(e.right)));
+}
+
+template <char X, typename L, typename R>
+constexpr auto differentiate(Div<L, R> e) {
+    return div(sub(mul(differentiate<X>(e.left), e.right), mul(e.left, differentiate<X>(e.right))), mul(e.right, e.right));
+}
+
+template <char X, typename L, typename R>
+constexpr auto differentiate(Pow<L, R> e) {
+    if constexpr (isInt<R>) {
+        return mul(mul(R{}, pow(e.left, Int<R::value - 1>{})), differentiate<X>(e.left));
+    } else if constexpr (std::is_same_v<R, Constant>) {
+        return mul(mul(e.right, pow(e.left, Constant(e.right.value - 1.0))), differentiate<X>(e.left));
+    } else {
+        return mul(e, add(mul(differentiate<X>(e.right), ln(e.left)), div(mul(e.right, differentiate<X>(e.left)), e.left)));
+    }
+}
+
+template <char X, typename A>
+constexpr auto differentiate(Sin<A> e) {
+    return mul(cos(e.arg), differentiate<X>(e.arg));
+}
+
+template <char X, typename A>
+constexpr auto differentiate(Cos<A> e) {
+    return mul(mul(Int<-1>{}, sin(e.arg)), differentiate<X>(e.arg));
+}
+
+template <char X, typename A>
+constexpr auto differentiate(Ln<A> e) {
+    return div(differentiate<X>(e.arg), e.arg);
+}
+
+template <char X, typename A>
+constexpr auto differentiate(Exp<A> e) {
+    return mul(e, differentiate<X>(e.arg));
+}
+
+}
+
+#endif
\ No newline at end of file
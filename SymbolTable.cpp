@@ -0,0 +1,50 @@
+#include "SymbolTable.hpp"
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+struct Symbols {
+    std::shared_mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, unsigned int> ids;
+};
+
+Symbols& symbols() {
+    static Symbols table;
+    return table;
+}
+
+}
+
+unsigned int SymbolTable::intern(const std::string& name) {
+    Symbols& table = symbols();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) return it->second;
+    unsigned int symbol = static_cast<unsigned int>(table.names.size());
+    table.names.push_back(name);
+    table.ids.emplace(name, symbol);
+    return symbol;
+}
+
+const std::string& SymbolTable::name(unsigned int symbol) {
+    Symbols& table = symbols();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    if (symbol >= table.names.size()) throw std::out_of_range("Unknown symbol");
+    return table.names[symbol];
+}
+
+size_t SymbolTable::size() {
+    Symbols& table = symbols();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names.size();
+}
\ No newline at end of file
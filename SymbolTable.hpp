@@ -0,0 +1,13 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <string>
+
+class SymbolTable {
+public:
+    static unsigned int intern(const std::string& name);
+    static const std::string& name(unsigned int symbol);
+    static size_t size();
+};
+
+#endif
\ No newline at end of file
@@ -1,7 +1,31 @@
 #include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include "ExpressionDag.hpp"
+#include "ExpressionParser.hpp"
+#include "NativeExpression.hpp"
+#include "ExpressionServer.hpp"
+#include "ExpressionCache.hpp"
+#include "ThreadPool.hpp"
+#include "ExpressionSystem.hpp"
+#include "ExpressionSimplifier.hpp"
+#include "ExpressionStats.hpp"
+#include "IncrementalEvaluator.hpp"
+#include "NewtonSolver.hpp"
+#include "Polynomial.hpp"
+#include "BulkEvaluator.hpp"
+#include "StaticExpression.hpp"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
 #include <iostream>
 #include <map>
 #include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
 
 void runTests() {
     Expression<double> x("x");
@@ -109,7 +133,776 @@ void runTests() {
         std::cout << "Test 12 FAIL (Expected " << expected12a << " or " << expected12b << ", got " << result12 << ")\n";
 }
 
+void runCompiledTests() {
+    Expression<double> expr = Expression<double>::fromString("x * sin(x) + y * cos(y) - exp(x / y) + ln(y) ^ 2");
+    CompiledExpression<double> compiled(expr);
+    bool match13 = true;
+    for (double px = -2.0; px <= 2.0; px += 0.5) {
+        for (double py = 0.5; py <= 3.0; py += 0.5) {
+            std::map<std::string, double> point = {{"x", px}, {"y", py}};
+            if (compiled.evaluate(point) != expr.evaluate(point)) match13 = false;
+        }
+    }
+    if (match13) std::cout << "Test 13 OK\n";
+    else std::cout << "Test 13 FAIL (Compiled result differs from evaluate)\n";
+
+    using C = std::complex<double>;
+    Expression<C> cexpr = Expression<C>::fromString("x * sin(x) + exp(y) / x ^ y");
+    CompiledExpression<C> ccompiled(cexpr);
+    std::map<std::string, C> cpoint = {{"x", C(1.0, 2.0)}, {"y", C(-0.5, 0.25)}};
+    std::vector<C> slots(ccompiled.variables().size());
+    for (const auto& [name, value] : cpoint) slots[ccompiled.slot(name)] = value;
+    C expected14 = cexpr.evaluate(cpoint);
+    C result14 = ccompiled.evaluate(slots);
+    if (result14 == expected14) std::cout << "Test 14 OK\n";
+    else std::cout << "Test 14 FAIL (Expected " << expected14 << ", got " << result14 << ")\n";
+}
+
+void runBatchTests() {
+    Expression<double> expr = Expression<double>::fromString("x * sin(x) + y * cos(y) - exp(x / y) + ln(y) ^ 2");
+    const size_t count = 1003;
+    std::vector<double> xs(count), ys(count), out(count);
+    for (size_t i = 0; i < count; i++) {
+        xs[i] = -20.0 + 40.0 * i / count;
+        ys[i] = 0.25 + 0.01 * i;
+    }
+    expr.evaluateBatch({{"x", xs.data()}, {"y", ys.data()}}, out.data(), count);
+    double worst15 = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double expected = expr.evaluate({{"x", xs[i]}, {"y", ys[i]}});
+        worst15 = std::max(worst15, std::abs(out[i] - expected) / std::max(1.0, std::abs(expected)));
+    }
+    if (worst15 < 1e-13) std::cout << "Test 15 OK\n";
+    else std::cout << "Test 15 FAIL (Batch differs from evaluate by " << worst15 << ")\n";
+
+    Expression<double> domain = Expression<double>::fromString("ln(x) + 1 / y");
+    std::vector<double> dx = {0.0, -1.0, 2.0, 1e300}, dy = {1.0, 2.0, 0.5, 0.0}, dout(4);
+    domain.evaluateBatch({{"x", dx.data()}, {"y", dy.data()}}, dout.data(), 4);
+    double inf = std::numeric_limits<double>::infinity();
+    if (dout[0] == -inf && dout[1] == -inf && std::abs(dout[2] - (std::log(2.0) + 2.0)) < 1e-15 && dout[3] == inf)
+        std::cout << "Test 16 OK\n";
+    else
+        std::cout << "Test 16 FAIL (Got " << dout[0] << ", " << dout[1] << ", " << dout[2] << ", " << dout[3] << ")\n";
+}
+
+void runDagTests() {
+    ExpressionDag<double> dag;
+    ExpressionDag<double>::NodeId shared = dag.fromExpression(Expression<double>::fromString("sin(x) * y + sin(x)"));
+    const ExpressionDag<double>::Node& sum = dag.node(shared);
+    if (dag.node(sum.left).left == sum.right) std::cout << "Test 17 OK\n";
+    else std::cout << "Test 17 FAIL (Equal subexpressions were not shared)\n";
+
+    const char* factors[] = {"sin(x)", "exp(x)", "ln(x)", "cos(x)"};
+    std::string chain = "x";
+    size_t previous = 0;
+    bool linear18 = true;
+    bool match18 = true;
+    for (int n = 1; n <= 40; n++) {
+        chain += std::string(" * ") + factors[n % 4];
+        ExpressionDag<double> chainDag;
+        ExpressionDag<double>::NodeId root = chainDag.fromExpression(Expression<double>::fromString(chain));
+        ExpressionDag<double>::NodeId derivative = chainDag.differentiate(root, "x");
+        size_t nodes = chainDag.reachable({derivative});
+        if (n > 1 && nodes - previous > 12) linear18 = false;
+        previous = nodes;
+        if (n <= 8) {
+            Expression<double> expected = Expression<double>::fromString(chain).differentiate("x");
+            double a = chainDag.evaluate(derivative, {{"x", 1.3}});
+            double b = expected.evaluate({{"x", 1.3}});
+            double c = chainDag.toExpression(derivative).evaluate({{"x", 1.3}});
+            if (std::abs(a - b) > 1e-12 * std::abs(b) || a != c) match18 = false;
+        }
+    }
+    // Expression::differentiate goes through the same memo, so a subtree
+    // shared 2^40 ways is differentiated once.
+    Expression<double> squared = Expression<double>::fromString("sin(x)");
+    for (int n = 0; n < 40; n++) squared = squared * squared;
+    Expression<double> squaredDerivative = squared.differentiate("x");
+    size_t shared18 = squaredDerivative.size();
+    if (shared18 > 400 || CompiledExpression<double>(squaredDerivative).size() > 4 * shared18) linear18 = false;
+
+    // Shared nodes are compiled once and reloaded, so the code follows the DAG.
+    std::string product = "x";
+    for (int n = 1; n < 128; n++) product += std::string(" * ") + factors[n % 4];
+    ExpressionDag<double> productDag;
+    ExpressionDag<double>::NodeId productRoot = productDag.differentiate(productDag.fromExpression(Expression<double>::fromString(product)), "x");
+    CompiledExpression<double> productCode(productDag.toExpression(productRoot));
+    double x18[] = {1.3};
+    const double* columns18[] = {x18};
+    double batch18 = 0.0, partial18 = 0.0;
+    productCode.evaluateBatch(columns18, &batch18, 1);
+    double value18 = productCode.gradient(x18, &partial18);
+    double exact18 = productDag.evaluate(productRoot, {{"x", 1.3}});
+    if (productCode.size() > 4 * productDag.reachable({productRoot}) || std::abs(value18 - exact18) > 1e-12 * std::abs(exact18)
+        || std::abs(batch18 - exact18) > 1e-12 * std::abs(exact18) || productCode.evaluate({{"x", 1.3}}) != value18) match18 = false;
+
+    // Both walks use explicit stacks, so depth is limited by the heap.
+    std::string deep18;
+    for (int n = 0; n < 200000; n++) deep18 += "sin(";
+    deep18 += "x" + std::string(200000, ')');
+    ExpressionDag<double> deepDag;
+    ExpressionDag<double>::NodeId deepRoot = deepDag.differentiate(deepDag.fromExpression(Expression<double>::fromString(deep18)), "x");
+    if (deepDag.reachable({deepRoot}) < 400000) match18 = false;
+    if (linear18 && match18) std::cout << "Test 18 OK\n";
+    else std::cout << "Test 18 FAIL (linear " << linear18 << ", match " << match18 << ", nodes " << previous << ", shared " << shared18 << ")\n";
+}
+
+void runGradientTests() {
+    Expression<double> expr = Expression<double>::fromString("x * sin(y) + exp(x / y) - ln(x) * y ^ 3 + x ^ y");
+    std::map<std::string, double> point = {{"x", 1.7}, {"y", 0.8}};
+    Gradient<double> grad = expr.gradient(point);
+    bool ok19 = std::abs(grad.value - expr.evaluate(point)) < 1e-12 && grad.partials.size() == 2;
+    for (const auto& [var, partial] : grad.partials) {
+        double expected = expr.differentiate(var).evaluate(point);
+        if (std::abs(partial - expected) > 1e-12 * std::max(1.0, std::abs(expected))) ok19 = false;
+    }
+    if (ok19) std::cout << "Test 19 OK\n";
+    else std::cout << "Test 19 FAIL (Gradient differs from differentiate)\n";
+
+    using C = std::complex<double>;
+    Expression<C> cexpr = Expression<C>::fromString("x * cos(x) / y + exp(y) ^ 2");
+    std::map<std::string, C> cpoint = {{"x", C(0.5, -1.0)}, {"y", C(2.0, 0.5)}};
+    Gradient<C> cgrad = cexpr.gradient(cpoint);
+    C expected20 = cexpr.differentiate("y").evaluate(cpoint);
+    if (std::abs(cgrad.partials["y"] - expected20) < 1e-12 * std::abs(expected20)) std::cout << "Test 20 OK\n";
+    else std::cout << "Test 20 FAIL (Expected " << expected20 << ", got " << cgrad.partials["y"] << ")\n";
+}
+
+void runArenaTests() {
+    bool compact21 = sizeof(ExpressionArena<double>::Node) <= 32 && sizeof(ExpressionArena<std::complex<double>>::Node) <= 32;
+    std::weak_ptr<ExpressionArena<double>> released;
+    size_t nodes21 = 0;
+    {
+        auto arena = std::make_shared<ExpressionArena<double>>();
+        released = arena;
+        ExpressionArena<double>::Scope scope(arena);
+        Expression<double> expr = Expression<double>::fromString("x * sin(x) + y");
+        nodes21 = arena->size();
+        std::weak_ptr<ExpressionArena<double>> inner;
+        {
+            auto request = std::make_shared<ExpressionArena<double>>();
+            inner = request;
+            ExpressionArena<double>::Scope nested(request);
+            Expression<double> derived = expr.differentiate("x") + expr;
+            if (arena->size() != nodes21 || derived.evaluate({{"x", 0.0}, {"y", 2.0}}) != 2.0) compact21 = false;
+        }
+        if (!inner.expired()) compact21 = false;
+        arena.reset();
+        if (expr.evaluate({{"x", 0.0}, {"y", 2.0}}) != 2.0) compact21 = false;
+    }
+    // Outside any Scope one long-lived variable must not pin every temporary.
+    Expression<double> kept21("x");
+    double last21 = 0.0;
+    for (int i = 0; i < 400000; ++i) last21 = (kept21 + Expression<double>(i)).evaluate({{"x", 1.0}});
+    if (last21 != 400000.0 || ExpressionArena<double>::current()->size() > 70000) compact21 = false;
+    if (compact21 && nodes21 == 6 && released.expired()) std::cout << "Test 21 OK\n";
+    else std::cout << "Test 21 FAIL (compact " << compact21 << ", nodes " << nodes21 << ", released " << released.expired() << ")\n";
+
+    Expression<double> remote(0.0);
+    std::thread worker([&remote]() { remote = Expression<double>::fromString("x ^ 2 + ln(y)"); });
+    worker.join();
+    Expression<double> combined = remote * Expression<double>("x") + remote;
+    double result22 = combined.differentiate("x").evaluate({{"x", 2.0}, {"y", 1.0}});
+    if (result22 == 16.0) std::cout << "Test 22 OK\n";
+    else std::cout << "Test 22 FAIL (Expected 16, got " << result22 << ")\n";
+}
+
+void runParserTests() {
+    double result23 = Expression<double>::fromString("a - b - c + 8 / 4 / 2").evaluate({{"a", 10}, {"b", 3}, {"c", 2}});
+    if (result23 == 6.0) std::cout << "Test 23 OK\n";
+    else std::cout << "Test 23 FAIL (Expected 6, got " << result23 << ")\n";
+
+    Expression<double> expr24 = Expression<double>::fromString("-x ^ 2 + 2 ^ -1 * rate_1 - 1.5e-1 * -.5E+1");
+    double result24 = expr24.evaluate({{"x", 3}, {"rate_1", 4}});
+    if (result24 == -9.0 + 2.0 + 0.75 && Expression<double>::fromString("-3").toString() == "-3") std::cout << "Test 24 OK\n";
+    else std::cout << "Test 24 FAIL (Expected -6.25, got " << result24 << ")\n";
+
+    size_t position25 = 0;
+    try {
+        Expression<double>::fromString("sin(x) * (y + foo(2))");
+    } catch (const ParseError& e) {
+        position25 = e.position();
+    }
+    // Nesting is limited by the heap, not the call stack.
+    size_t levels25 = 200000;
+    std::string deep25 = std::string(levels25, '(') + "x" + std::string(levels25, ')') + " + ";
+    for (size_t i = 0; i < levels25; ++i) deep25 += "sin(-";
+    deep25 += "x" + std::string(levels25, ')');
+    Expression<double> nested25 = Expression<double>::fromString(deep25);
+    size_t unclosed25 = 0;
+    try {
+        Expression<double>::fromString(std::string(levels25, '(') + "x");
+    } catch (const ParseError& e) {
+        unclosed25 = e.position();
+    }
+    bool deepOk25 = nested25.depth() == 2 * levels25 + 2 && unclosed25 == levels25 + 1;
+    if (position25 == 14 && deepOk25) std::cout << "Test 25 OK\n";
+    else std::cout << "Test 25 FAIL (Expected error at 14, got " << position25 << ", deep " << deepOk25 << ")\n";
+}
+
+void runBindingTests() {
+    Expression<double> expr26 = Expression<double>::fromString("y * sin(x) - x / y + y");
+    CompiledExpression<double> bound26 = expr26.bind({"y", "x"});
+    double values26[] = {2.0, 0.5};
+    double result26 = bound26.evaluate(values26);
+    double expected26 = expr26.evaluate({{"x", 0.5}, {"y", 2.0}});
+    if (result26 == expected26 && bound26.slot("x") == 1) std::cout << "Test 26 OK\n";
+    else std::cout << "Test 26 FAIL (Expected " << expected26 << ", got " << result26 << ")\n";
+
+    std::vector<std::string> names27 = expr26.variables();
+    double result27 = expr26.bind(names27).evaluate(std::vector<double>{0.5, 2.0});
+    if (names27 == std::vector<std::string>{"x", "y"} && result27 == expected26) std::cout << "Test 27 OK\n";
+    else std::cout << "Test 27 FAIL (Expected " << expected26 << ", got " << result27 << ")\n";
+
+    bool threw28 = false;
+    try {
+        expr26.bind({"x"});
+    } catch (const std::invalid_argument&) {
+        threw28 = true;
+    }
+    if (threw28) std::cout << "Test 28 OK\n";
+    else std::cout << "Test 28 FAIL (Expected unbound variable error)\n";
+}
+
+void runNativeTests() {
+    Expression<double> expr29 = Expression<double>::fromString("x ^ 2.5 * sin(y) / (x - y) + ln(x * y) - exp(-y) * 0.1");
+    NativeExpression native29(expr29, {"x", "y"});
+    Expression<double> dx29 = expr29.differentiate("x");
+    Expression<double> dy29 = expr29.differentiate("y");
+    auto same = [](double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0 || (a != a && b != b); };
+    bool exact29 = true;
+    for (double x = 0.25; x < 4.0; x += 0.375) {
+        for (double y = 0.125; y < 4.0; y += 0.625) {
+            double point[] = {x, y};
+            std::map<std::string, double> values{{"x", x}, {"y", y}};
+            if (!same(native29.evaluate(point), expr29.evaluate(values))) exact29 = false;
+            if (!same(native29.derivative("x", point), dx29.evaluate(values))) exact29 = false;
+            if (!same(native29.derivative("y", point), dy29.evaluate(values))) exact29 = false;
+        }
+    }
+    if (exact29) std::cout << "Test 29 OK\n";
+    else std::cout << "Test 29 FAIL (Native results differ from evaluate)\n";
+
+    NativeExpression again30(expr29, {"x", "y"});
+    bool threw30 = false;
+    try {
+        native29.function("z");
+    } catch (const std::invalid_argument&) {
+        threw30 = true;
+    }
+    if (again30.cached() && again30.library() == native29.library() && threw30) std::cout << "Test 30 OK\n";
+    else std::cout << "Test 30 FAIL (Expected the shared object to be reused from " << NativeExpression::cacheDirectory() << ")\n";
+}
+
+void runServerTests() {
+    ExpressionServer server31;
+    std::string eval31 = server31.respond("eval x * y + 2 x=3 y=4");
+    std::string diff31 = server31.respond("diff x * y + 2 by x");
+    std::string error31 = server31.respond("eval sin(x");
+    if (eval31 == "14" && diff31 == "y" && error31.rfind("error: ", 0) == 0 && server31.cache().counters().entries == 2) std::cout << "Test 31 OK\n";
+    else std::cout << "Test 31 FAIL (Got '" << eval31 << "', '" << diff31 << "', '" << error31 << "')\n";
+
+    int sockets[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+    std::string requests32;
+    for (int i = 0; i < 100; i++) requests32 += "eval x ^ 2 + 1 x=" + std::to_string(i) + "\n";
+    requests32 += "diff x ^ 2 + 1 by x";
+    std::thread worker([&]() { ExpressionServer().serve(sockets[1], sockets[1]); });
+    if (write(sockets[0], requests32.data(), requests32.size()) != static_cast<ssize_t>(requests32.size())) std::cout << "Test 32 FAIL (Short write)\n";
+    shutdown(sockets[0], SHUT_WR);
+    worker.join();
+    close(sockets[1]);
+    std::string replies32;
+    char buffer[4096];
+    for (ssize_t n; (n = read(sockets[0], buffer, sizeof(buffer))) > 0;) replies32.append(buffer, static_cast<size_t>(n));
+    close(sockets[0]);
+    std::string expected32;
+    for (int i = 0; i < 100; i++) expected32 += std::to_string(i * i + 1) + "\n";
+    expected32 += "(2 * x)\n";
+    if (replies32 == expected32) std::cout << "Test 32 OK\n";
+    else std::cout << "Test 32 FAIL (Unexpected replies: " << replies32.substr(replies32.size() > 40 ? replies32.size() - 40 : 0) << ")\n";
+}
+
+void runCacheTests() {
+    ExpressionCache<double> cache33(1 << 20);
+    auto first33 = cache33.parse("x * y +  sin(x)");
+    auto second33 = cache33.parse("x*y+sin( x )");
+    auto derivative33 = cache33.derivative("x * y + sin(x)", "x");
+    auto compiled33 = cache33.compile("x*y + sin(x)");
+    ExpressionCache<double>::Counters counters33 = cache33.counters();
+    double result33 = compiled33->compiled->evaluate({{"x", 0.0}, {"y", 2.0}});
+    if (first33 == second33 && derivative33->expr.evaluate({{"x", 0.0}, {"y", 2.0}}) == 3.0 && result33 == 0.0
+        && counters33.hits == 3 && counters33.misses == 2 && counters33.entries == 2) std::cout << "Test 33 OK\n";
+    else std::cout << "Test 33 FAIL (Got " << counters33.hits << " hits, " << counters33.misses << " misses)\n";
+
+    ExpressionCache<double> small34(64 << 10);
+    std::shared_ptr<const CompiledExpression<double>> shared34 = compiled33->compiled;
+    std::atomic<bool> agreed34{true};
+    std::vector<std::thread> workers34;
+    for (int t = 0; t < 4; t++) {
+        workers34.emplace_back([&small34, &shared34, &agreed34, t]() {
+            for (int i = 0; i < 200; i++) {
+                std::string text = "x ^ " + std::to_string((i + t) % 16) + " + y";
+                small34.derivative(text, "x");
+                double point[] = {0.001 * i, double(t)};
+                double expected = point[0] * point[1] + std::sin(point[0]);
+                double partials[2];
+                if (shared34->evaluate(point) != expected || shared34->gradient(point, partials) != expected) agreed34 = false;
+            }
+        });
+    }
+    for (std::thread& worker : workers34) worker.join();
+    ExpressionCache<double>::Counters counters34 = small34.counters();
+    if (counters34.bytes <= small34.capacity() && counters34.evictions > 0 && counters34.hits + counters34.misses >= 800 && agreed34)
+        std::cout << "Test 34 OK\n";
+    else std::cout << "Test 34 FAIL (Got " << counters34.bytes << " bytes after " << counters34.evictions << " evictions)\n";
+}
+
+void runThreadPoolTests() {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> visits35(100003);
+    pool.parallelFor(visits35.size(), 97, [&visits35](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) visits35[i]++;
+    });
+    bool once35 = std::all_of(visits35.begin(), visits35.end(), [](const std::atomic<int>& v) { return v == 1; });
+    bool threw35 = false;
+    try {
+        pool.parallelFor(1000, 10, [](size_t begin, size_t) {
+            if (begin == 500) throw std::runtime_error("chunk failed");
+        });
+    } catch (const std::runtime_error&) {
+        threw35 = true;
+    }
+    if (once35 && threw35 && pool.size() == 4) std::cout << "Test 35 OK\n";
+    else std::cout << "Test 35 FAIL (Every index must be visited once and errors must propagate)\n";
+
+    Expression<double> expr36 = Expression<double>::fromString("x * sin(x) + y ^ 3 / (1 + exp(-x)) - ln(y)");
+    size_t count36 = 200001;
+    std::vector<double> xs(count36), ys(count36), serial36(count36), parallel36(count36);
+    for (size_t i = 0; i < count36; i++) {
+        xs[i] = -5.0 + 10.0 * i / count36;
+        ys[i] = 0.5 + 3.0 * i / count36;
+    }
+    std::map<std::string, const double*> columns36{{"x", xs.data()}, {"y", ys.data()}};
+    expr36.evaluateBatch(columns36, serial36.data(), count36);
+    expr36.evaluateBatch(columns36, parallel36.data(), count36, pool);
+    if (serial36 == parallel36) std::cout << "Test 36 OK\n";
+    else std::cout << "Test 36 FAIL (Parallel batch differs from serial batch)\n";
+}
+
+void runSystemTests() {
+    std::vector<Expression<double>> exprs37{
+        Expression<double>::fromString("x * y + sin(x)"),
+        Expression<double>::fromString("z ^ 2"),
+        Expression<double>::fromString("exp(x * z)")};
+    ExpressionSystem<double> system37(exprs37, {"x", "y", "z", "w"});
+    const std::vector<ExpressionSystem<double>::Entry>& jacobian37 = system37.jacobian();
+    std::vector<double> values37 = system37.evaluate(jacobian37, {0.5, 2.0, 1.5, 9.0});
+    std::map<std::pair<size_t, size_t>, double> dense37;
+    for (size_t e = 0; e < jacobian37.size(); e++) dense37[{jacobian37[e].row, jacobian37[e].col}] = values37[e];
+    bool ok37 = jacobian37.size() == 5 && dense37.at({0, 0}) == 2.0 + std::cos(0.5) && dense37.at({0, 1}) == 0.5
+        && dense37.at({1, 2}) == 3.0 && dense37.at({2, 0}) == 1.5 * std::exp(0.75) && !dense37.count({1, 0});
+    // Differentiating by x alone still binds y and z from the point.
+    ExpressionSystem<double> byX37(exprs37, {"x"});
+    std::vector<double> partial37 = byX37.evaluate(byX37.jacobian(), std::map<std::string, double>{{"x", 0.5}, {"y", 2.0}, {"z", 1.5}});
+    ok37 = ok37 && partial37.size() == 2 && partial37[0] == dense37.at({0, 0}) && partial37[1] == dense37.at({2, 0});
+    if (ok37) std::cout << "Test 37 OK\n";
+    else std::cout << "Test 37 FAIL (Got " << jacobian37.size() << " structural nonzeros)\n";
+
+    const std::vector<ExpressionSystem<double>::Entry>& hessian38 = system37.hessian(0);
+    std::vector<double> second38 = system37.evaluate(hessian38, {0.5, 2.0, 1.5, 9.0});
+    bool ok38 = hessian38.size() == 2 && hessian38[0].row == 0 && hessian38[0].col == 0 && second38[0] == -std::sin(0.5)
+        && hessian38[1].row == 0 && hessian38[1].col == 1 && second38[1] == 1.0 && system37.hessian(1).size() == 1;
+    if (ok38) std::cout << "Test 38 OK\n";
+    else std::cout << "Test 38 FAIL (Got " << hessian38.size() << " Hessian entries)\n";
+}
+
+void runSimplifierTests() {
+    std::string result39 = Expression<double>::fromString("2 * 3 * x + x - x * 1 + x * x / x - (y - y)").simplified().toString();
+    std::string powers39 = Expression<double>::fromString("x ^ 2 * x ^ 3 * ln(exp(y)) / y").simplified().toString();
+    std::string exps39 = Expression<double>::fromString("exp(x) * exp(2 * x) + sin(0) + 2 ^ 3").simplified().toString();
+    if (result39 == "(7 * x)" && powers39 == "(x ^ 5)" && exps39 == "(exp((3 * x)) + 8)") std::cout << "Test 39 OK\n";
+    else std::cout << "Test 39 FAIL (Got " << result39 << ", " << powers39 << ", " << exps39 << ")\n";
+
+    Expression<double> expr40 = Expression<double>::fromString("(x + y) * (x + y) - 3 * x / (2 * x) + sin(x) ^ 2 * sin(x) - 4 * y + y * 4 + x / 0");
+    ExpressionSimplifier<double> simplifier40;
+    Expression<double> simplified40 = simplifier40.simplify(expr40);
+    bool same40 = true;
+    for (double px = 0.25; px < 3.0; px += 0.5) {
+        std::map<std::string, double> point{{"x", px}, {"y", 1.5 - px}};
+        double a = expr40.evaluate(point);
+        double b = simplified40.evaluate(point);
+        if (a != b && std::abs(a - b) > 1e-12 * std::abs(a)) same40 = false;
+    }
+    ExpressionSimplifier<double> limited40(1);
+    Expression<double> partial40 = limited40.simplify(expr40);
+    bool bounded40 = limited40.stats().exhausted && partial40.evaluate({{"x", 0.5}, {"y", 1.0}}) == expr40.evaluate({{"x", 0.5}, {"y", 1.0}});
+    if (same40 && bounded40 && simplifier40.stats().after < simplifier40.stats().before) std::cout << "Test 40 OK\n";
+    else std::cout << "Test 40 FAIL (Got " << simplified40.toString() << " with " << simplifier40.stats().after << " nodes)\n";
+}
+
+void runStatsTests() {
+    ExpressionStats::enable();
+    ExpressionStats::reset();
+    Expression<double> expr41 = Expression<double>::fromString("sin(x * y) + x ^ 3");
+    Expression<double> diff41 = expr41.differentiate("x");
+    ExpressionStats::Counters on41 = ExpressionStats::counters();
+    ExpressionStats::enable(false);
+    ExpressionStats::reset();
+    Expression<double>::fromString("sin(x * y) + x ^ 3").differentiate("x");
+    ExpressionStats::Counters off41 = ExpressionStats::counters();
+    bool recorded41 = on41.nodesCreated > 0 && on41.peakLiveNodes > 0 && on41.maxDepth == std::max(expr41.depth(), diff41.depth())
+        && on41.calls[ExpressionStats::PARSE] == 1 && on41.calls[ExpressionStats::DIFFERENTIATE] == 1
+        && on41.differentiatedNodes == expr41.size() && on41.derivativeNodes == diff41.size();
+    bool silent41 = off41.nodesCreated == 0 && off41.calls[ExpressionStats::PARSE] == 0 && off41.maxDepth == 0;
+    if (expr41.depth() == 4 && recorded41 && silent41) std::cout << "Test 41 OK\n";
+    else std::cout << "Test 41 FAIL (Got depth " << expr41.depth() << ", " << on41.nodesCreated << " nodes created)\n";
+}
+
+void runComplexBatchTests() {
+    using C = std::complex<double>;
+    Expression<C> expr42 = Expression<C>::fromString("x * sin(x) + exp(y) / x ^ y - cos(x * y) + ln(x) * (x - y) / (y + 2)");
+    CompiledExpression<C> compiled42 = expr42.bind({"x", "y"});
+    const size_t count = 1001;
+    std::vector<double> xr(count), xi(count), yr(count), yi(count), outR(count), outI(count);
+    std::vector<C> xs(count), ys(count), out(count);
+    for (size_t i = 0; i < count; i++) {
+        xs[i] = C(-3.0 + 6.0 * i / count, 0.001 * i - 0.4);
+        ys[i] = C(0.5 + std::sin(0.1 * i), 2.0 - 4.0 * i / count);
+        xr[i] = xs[i].real();
+        xi[i] = xs[i].imag();
+        yr[i] = ys[i].real();
+        yi[i] = ys[i].imag();
+    }
+    const double* real42[] = {xr.data(), yr.data()};
+    const double* imag42[] = {xi.data(), yi.data()};
+    compiled42.evaluateBatch(real42, imag42, outR.data(), outI.data(), count);
+    const C* columns42[] = {xs.data(), ys.data()};
+    compiled42.evaluateBatch(columns42, out.data(), count);
+    double worst42 = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        C expected = expr42.evaluate({{"x", xs[i]}, {"y", ys[i]}});
+        worst42 = std::max(worst42, std::abs(C(outR[i], outI[i]) - expected) / std::abs(expected));
+        worst42 = std::max(worst42, std::abs(out[i] - expected) / std::abs(expected));
+    }
+    bool threw42 = false;
+    try {
+        const double* zero42[] = {xr.data(), nullptr};
+        std::vector<double> zeros(count, 0.0);
+        zero42[1] = zeros.data();
+        const double* none42[] = {xi.data(), nullptr};
+        Expression<C>::fromString("x / y").bind({"x", "y"}).evaluateBatch(zero42, none42, outR.data(), outI.data(), count);
+    } catch (const std::runtime_error&) {
+        threw42 = true;
+    }
+    if (worst42 < 1e-12 && threw42) std::cout << "Test 42 OK\n";
+    else std::cout << "Test 42 FAIL (Worst relative error " << worst42 << ")\n";
+}
+
+void runIncrementalTests() {
+    Expression<double> expr43 = Expression<double>::fromString("sin(a) * exp(b) + (a * b) ^ 2 * x + ln(b + 3) / (a + 1) - cos(a - b) * y + x ^ 0 * (a + b)");
+    IncrementalEvaluator<double> incremental43(expr43);
+    std::map<std::string, double> point43{{"a", 0.3}, {"b", 1.7}, {"x", -2.0}, {"y", 0.5}};
+    for (const auto& [name, value] : point43) incremental43.set(name, value);
+    bool match43 = incremental43.value() == expr43.evaluate(point43) && incremental43.recomputed() == incremental43.size();
+    size_t worst43 = 0;
+    for (int step = 0; step < 20; step++) {
+        point43[step % 2 ? "x" : "y"] += 0.125 * step;
+        incremental43.set(step % 2 ? "x" : "y", point43[step % 2 ? "x" : "y"]);
+        if (incremental43.value() != expr43.evaluate(point43)) match43 = false;
+        worst43 = std::max(worst43, incremental43.recomputed());
+    }
+    point43["a"] = -0.8;
+    incremental43.set("a", -0.8);
+    if (incremental43.value() != expr43.evaluate(point43)) match43 = false;
+    incremental43.set("x", point43["x"]);
+    bool idle43 = incremental43.value() == expr43.evaluate(point43) && incremental43.recomputed() == 0;
+
+    IncrementalEvaluator<double> cutoff43(Expression<double>::fromString("x ^ 0 * sin(y) + y"));
+    cutoff43.set("x", 2.0);
+    cutoff43.set("y", 1.0);
+    cutoff43.value();
+    cutoff43.set("x", 3.0);
+    bool stopped43 = cutoff43.value() == std::sin(1.0) + 1.0 && cutoff43.recomputed() == 1;
+    if (match43 && idle43 && stopped43 && worst43 * 3 < incremental43.size()) std::cout << "Test 43 OK\n";
+    else std::cout << "Test 43 FAIL (Recomputed up to " << worst43 << " of " << incremental43.size() << " nodes)\n";
+}
+
+void runSpecializeTests() {
+    std::string text44 = "x * y";
+    std::map<std::string, double> params44;
+    for (int i = 0; i < 20; i++) {
+        std::string p = "p" + std::to_string(i);
+        params44[p] = 0.1 * (i + 1);
+        text44 += " + " + p + " * sin(" + p + " + 1) * " + (i % 2 ? "x" : "exp(y / 3)") + " - ln(" + p + ") / (" + p + " + 2)";
+    }
+    Expression<double> expr44 = Expression<double>::fromString(text44);
+    Expression<double> residual44 = expr44.specialize(params44);
+    std::vector<std::string> vars44 = residual44.variables();
+    bool match44 = vars44 == std::vector<std::string>{"x", "y"};
+    for (double x = -1.0; x <= 1.0; x += 0.5) {
+        std::map<std::string, double> point = params44;
+        point["x"] = x;
+        point["y"] = 0.75 - x;
+        double a = expr44.evaluate(point);
+        double b = residual44.evaluate({{"x", x}, {"y", 0.75 - x}});
+        if (std::abs(a - b) > 1e-12 * std::abs(a)) match44 = false;
+    }
+    Expression<double> folded44 = Expression<double>::fromString("a * b + sin(a) - x * (a - a)").specialize({{"a", 2.0}, {"b", 3.0}});
+    bool fold44 = folded44.size() == 1 && folded44.evaluate(std::map<std::string, double>{}) == 6.0 + std::sin(2.0);
+    Expression<double> untouched44 = Expression<double>::fromString("sin(x) * y");
+    bool shared44 = untouched44.specialize({{"z", 1.0}}).toString() == untouched44.toString();
+    if (match44 && fold44 && shared44 && residual44.size() * 2 < expr44.size()) std::cout << "Test 44 OK\n";
+    else std::cout << "Test 44 FAIL (Got " << residual44.size() << " of " << expr44.size() << " nodes, " << folded44.toString() << ")\n";
+}
+
+void runSolverTests() {
+    std::vector<double> starts45;
+    for (int i = 0; i <= 40; i++) starts45.push_back(0.5 * i - 2.5);
+    NewtonSolver roots45(Expression<double>::fromString("x ^ 3 - 2 * x - 5"), "x");
+    bool root45 = true;
+    for (const NewtonSolver::Result& r : roots45.solve(starts45)) {
+        // A start that descends into the local minimum of |f| near -0.8165 has no root to reach and must say so.
+        if (r.converged ? std::abs(r.x - 2.0945514815423265) > 1e-12 || r.residual > 1e-10 : r.residual < 1.0) root45 = false;
+    }
+    NewtonSolver minimum45(Expression<double>::fromString("(x - 2) ^ 2 + exp(x)"), "x", true);
+    bool min45 = true;
+    for (const NewtonSolver::Result& r : minimum45.solve(starts45)) {
+        if (!r.converged || std::abs(2 * (r.x - 2) + std::exp(r.x)) > 1e-10) min45 = false;
+    }
+    std::vector<NewtonSolver::Result> none45 = NewtonSolver(Expression<double>::fromString("x ^ 2 + 1"), "x").solve({-1.0, 0.0, 3.0}, 20);
+    bool fail45 = !none45[0].converged && !none45[1].converged && !none45[2].converged && none45[2].iterations <= 20;
+    if (root45 && min45 && fail45) std::cout << "Test 45 OK\n";
+    else std::cout << "Test 45 FAIL (root " << root45 << ", minimum " << min45 << ", no root " << fail45 << ")\n";
+}
+
+void runPolynomialTests() {
+    Expression<double> cubic46 = Expression<double>::fromString("x ^ 3 + 5 * x ^ 2 - 3 * x + 7");
+    std::optional<Polynomial<double>> poly46 = Polynomial<double>::fromExpression(cubic46);
+    bool dense46 = poly46 && poly46->coefficients() == std::vector<double>{7, -3, 5, 1}
+        && poly46->derivative("x").coefficients() == std::vector<double>{-3, 10, 3, 0};
+    CompiledExpression<double> compiled46(cubic46);
+    double x46 = 1.5;
+    bool fused46 = compiled46.size() == 1 && compiled46.evaluate(&x46) == 17.125
+        && cubic46.differentiate("x").evaluate({{"x", 1.5}}) == 18.75;
+
+    std::string wide = "x ^ 12";
+    for (int k = 11; k >= 0; k--) wide += " + " + std::to_string(k + 1) + " * x ^ " + std::to_string(k) + " * y ^ " + std::to_string(k % 3);
+    Expression<double> expr46 = Expression<double>::fromString(wide + " + sin(x)");
+    CompiledExpression<double> tape46(expr46);
+    std::vector<double> xs46, ys46, out46(1000);
+    for (int i = 0; i < 1000; i++) {
+        xs46.push_back(-1.1 + 0.0021 * i);
+        ys46.push_back(0.3 + 0.0007 * i);
+    }
+    const double* columns46[] = {xs46.data(), ys46.data()};
+    tape46.evaluateBatch(columns46, out46.data(), out46.size());
+    bool batch46 = tape46.variables() == std::vector<std::string>{"x", "y"};
+    for (int i = 0; i < 1000; i++) {
+        double expected = expr46.evaluate({{"x", xs46[i]}, {"y", ys46[i]}});
+        double point[] = {xs46[i], ys46[i]};
+        if (std::abs(out46[i] - expected) > 1e-12 * (1 + std::abs(expected))) batch46 = false;
+        if (std::abs(tape46.evaluate(point) - expected) > 1e-12 * (1 + std::abs(expected))) batch46 = false;
+    }
+    bool generic46 = !Polynomial<double>::fromExpression(Expression<double>::fromString("x ^ 2.5 + x"))
+        && !Polynomial<double>::fromExpression(Expression<double>::fromString("x / y"))
+        && !Polynomial<double>::fromExpression(Expression<double>::fromString("(x - 1) * (x + 1)"));
+    Expression<double> factored46 = Expression<double>::fromString("(x - 1.001) ^ 8");
+    double one46 = 1.0, near46 = 1.0000001;
+    generic46 = generic46 && !Polynomial<double>::fromExpression(factored46)
+        && std::abs(CompiledExpression<double>(factored46).evaluate(&one46) - 1e-24) < 1e-32
+        && std::abs(CompiledExpression<double>(Expression<double>::fromString("(x - 1) ^ 3")).evaluate(&near46) - 1e-21) < 1e-27;
+    // Mostly-zero layouts stay generic, and wide linear sums are never expanded.
+    CompiledExpression<double> sparse46(Expression<double>::fromString("x^3 * y^3 * z^3 * w^3 * v^3"));
+    std::string linear46 = "3 * a0";
+    for (int i = 1; i < 20000; i++) linear46 += " + 3 * a" + std::to_string(i);
+    CompiledExpression<double> wideSum46(Expression<double>::fromString(linear46));
+    std::vector<double> ones46(wideSum46.variables().size(), 1.0);
+    generic46 = generic46 && sparse46.size() > 1 && wideSum46.evaluate(ones46.data()) == 60000.0;
+    if (dense46 && fused46 && batch46 && generic46) std::cout << "Test 46 OK\n";
+    else std::cout << "Test 46 FAIL (dense " << dense46 << ", fused " << fused46 << ", batch " << batch46 << ", generic " << generic46 << ")\n";
+}
+
+void runBulkTests() {
+    std::string csvPath = "bulk47.csv", columnPath = "bulk47.cols", resultPath = "bulk47.out";
+    {
+        std::ofstream csv(csvPath);
+        csv << "y, x, unused\n";
+        for (int i = 0; i < 10000; i++) csv << 0.001 * i << "," << 1.0 - 0.0003 * i << ",7\n";
+    }
+    Expression<double> expr47 = Expression<double>::fromString("x * sin(y) + y ^ 2");
+    BulkEvaluator bulk47(expr47, {"x", "y"});
+    size_t packed47 = BulkEvaluator::pack(csvPath, columnPath);
+    bulk47.evaluate(ColumnFile(columnPath), resultPath);
+
+    ColumnFile result47(resultPath);
+    bool mapped47 = packed47 == 10000 && result47.rows() == 10000
+        && result47.names() == std::vector<std::string>{"value", "d/dx", "d/dy"};
+    Expression<double> dx47 = expr47.differentiate("x"), dy47 = expr47.differentiate("y");
+    for (size_t i = 0; mapped47 && i < result47.rows(); i++) {
+        std::map<std::string, double> point{{"x", 1.0 - 0.0003 * i}, {"y", 0.001 * i}};
+        if (std::abs(result47.column(0)[i] - expr47.evaluate(point)) > 1e-12
+            || std::abs(result47.column(1)[i] - dx47.evaluate(point)) > 1e-12
+            || std::abs(result47.column(2)[i] - dy47.evaluate(point)) > 1e-12) mapped47 = false;
+    }
+
+    std::ifstream csv47(csvPath);
+    std::ostringstream streamed47;
+    size_t rows47 = bulk47.evaluateCsv(csv47, streamed47).points();
+    std::istringstream lines47(streamed47.str());
+    std::string line47;
+    std::getline(lines47, line47);
+    bool csvOk47 = rows47 == 10000 && line47 == "value,d/dx,d/dy";
+    for (size_t i = 0; csvOk47 && std::getline(lines47, line47); i++) {
+        if (std::stod(line47) != result47.column(0)[i]) csvOk47 = false;
+    }
+
+    {
+        std::ofstream csv(csvPath);
+        csv << "x,y\n";
+    }
+    bool edges47 = BulkEvaluator::pack(csvPath, columnPath) == 0 && ColumnFile(columnPath).rows() == 0;
+    {
+        std::fstream file(columnPath, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t rows = uint64_t(1) << 61;
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+    }
+    try {
+        ColumnFile corrupt47(columnPath);
+        edges47 = false;
+    } catch (const std::runtime_error&) {
+    }
+    std::remove(csvPath.c_str());
+    std::remove(columnPath.c_str());
+    std::remove(resultPath.c_str());
+    if (mapped47 && csvOk47 && edges47) std::cout << "Test 47 OK\n";
+    else std::cout << "Test 47 FAIL (mapped " << mapped47 << ", csv " << csvOk47 << ", edges " << edges47 << ")\n";
+}
+
+void runStaticTests() {
+    using namespace ct;
+    constexpr Var<'x'> x;
+    constexpr Var<'y'> y;
+    constexpr auto cubic48 = (x ^ 3_c) + 5.0 * (x ^ 2_c) - 3.0 * x + 7.0;
+    static_assert(cubic48.evaluate(values<'x'>(2.0)) == 29.0, "constexpr evaluation");
+    static_assert(differentiate<'x'>(cubic48).evaluate(values<'x'>(2.0)) == 29.0, "constexpr derivative");
+    static_assert(std::is_same_v<std::decay_t<decltype(differentiate<'y'>(cubic48))>, Int<0>>, "zero derivative folds away");
+
+    auto f48 = x * sin(y) + (x ^ 3_c) / 2.0 + exp(x * y) - ln(x) + (x ^ y) + cos(x / y);
+    Expression<double> runtime48 = f48.toExpression<double>();
+    Expression<double> parsed48 = Expression<double>::fromString("x * sin(y) + x ^ 3 / 2 + exp(x * y) - ln(x) + x ^ y + cos(x / y)");
+    bool same48 = true;
+    for (double px : {0.3, 1.5, 2.25}) {
+        for (double py : {-0.7, 0.4, 1.9}) {
+            auto point = values<'x', 'y'>(px, py);
+            std::map<std::string, double> named{{"x", px}, {"y", py}};
+            auto close = [](double a, double b) { return std::abs(a - b) <= 1e-12 * (1 + std::abs(b)); };
+            if (!close(f48.evaluate(point), parsed48.evaluate(named))) same48 = false;
+            if (!close(runtime48.evaluate(named), parsed48.evaluate(named))) same48 = false;
+            if (!close(differentiate<'x'>(f48).evaluate(point), parsed48.differentiate("x").evaluate(named))) same48 = false;
+            if (!close(differentiate<'y'>(f48).evaluate(point), parsed48.differentiate("y").evaluate(named))) same48 = false;
+        }
+    }
+    std::complex<double> z48(0.5, 0.25);
+    bool complex48 = std::abs(f48.evaluate(Values<std::complex<double>, 'x', 'y'>{{z48, z48}})
+                              - f48.toExpression<std::complex<double>>().evaluate({{"x", z48}, {"y", z48}})) < 1e-12;
+    if (same48 && complex48) std::cout << "Test 48 OK\n";
+    else std::cout << "Test 48 FAIL (real " << same48 << ", complex " << complex48 << ")\n";
+}
+
+void runDomainTests() {
+    CompiledExpression<double> compiled49(Expression<double>::fromString("ln(x) / y + x"));
+    const size_t rows49 = 5000;
+    std::vector<double> x49(rows49), y49(rows49), out49(rows49), pooled49(rows49);
+    for (size_t i = 0; i < rows49; i++) {
+        x49[i] = i % 1000 == 3 ? 0.0 : 0.5 + 0.001 * i;
+        y49[i] = i % 1000 == 7 ? 0.0 : 1.0 + 0.002 * i;
+    }
+    std::vector<const double*> columns49;
+    for (const std::string& var : compiled49.variables()) columns49.push_back(var == "x" ? x49.data() : y49.data());
+    std::vector<unsigned char> status49(rows49), pooledStatus49(rows49);
+
+    std::ostringstream quiet49;
+    std::streambuf* saved49 = std::cerr.rdbuf(quiet49.rdbuf());
+    compiled49.evaluateBatch(columns49.data(), out49.data(), rows49, status49.data());
+    ThreadPool pool49(4);
+    compiled49.evaluateBatch(columns49.data(), pooled49.data(), rows49, pooledStatus49.data(), pool49);
+    bool batch49 = status49 == pooledStatus49;
+    for (size_t i = 0; batch49 && i < rows49; i++) {
+        double values[2];
+        values[compiled49.slot("x")] = x49[i];
+        values[compiled49.slot("y")] = y49[i];
+        double scratch[8];
+        unsigned char flags = 0;
+        double scalar = compiled49.evaluate(values, scratch, flags);
+        unsigned char expected = i % 1000 == 3 ? LOG_DOMAIN | NOT_FINITE : i % 1000 == 7 ? DIVISION_BY_ZERO | NOT_FINITE : 0;
+        if (flags != expected || status49[i] != expected) batch49 = false;
+        if (!expected && std::abs(scalar - out49[i]) > 1e-12 * std::abs(scalar)) batch49 = false;
+        if (expected && scalar != out49[i] && !(scalar != scalar && out49[i] != out49[i])) batch49 = false;
+    }
+    DomainReport report49;
+    report49.record(status49.data(), rows49);
+    bool report49Ok = report49.points() == rows49 && report49.flagged() == 10 && report49.count(LOG_DOMAIN) == 5
+        && report49.count(DIVISION_BY_ZERO) == 5 && report49.count(NOT_FINITE) == 10;
+
+    CompiledExpression<std::complex<double>> complex49(Expression<std::complex<double>>::fromString("1 / z + ln(z)"));
+    std::vector<std::complex<double>> z49{{1.0, 1.0}, {0.0, 0.0}, {2.0, -1.0}}, zOut49(3);
+    const std::complex<double>* zColumns49[] = {z49.data()};
+    unsigned char zStatus49[3];
+    complex49.evaluateBatch(zColumns49, zOut49.data(), 3, zStatus49);
+    bool complex49Ok = zStatus49[0] == 0 && zStatus49[1] == (DIVISION_BY_ZERO | LOG_DOMAIN | NOT_FINITE) && zStatus49[2] == 0
+        && std::abs(zOut49[2] - (1.0 / z49[2] + std::log(z49[2]))) < 1e-12;
+    double zReal49[] = {1.0, 0.0, 2.0}, zImag49[] = {1.0, 0.0, -1.0}, splitReal49[3], splitImag49[3];
+    const double* zRealColumns49[] = {zReal49};
+    const double* zImagColumns49[] = {zImag49};
+    unsigned char splitStatus49[3];
+    complex49.evaluateBatch(zRealColumns49, zImagColumns49, splitReal49, splitImag49, 3, splitStatus49);
+    complex49Ok = complex49Ok && std::equal(zStatus49, zStatus49 + 3, splitStatus49)
+        && std::abs(std::complex<double>(splitReal49[2], splitImag49[2]) - zOut49[2]) < 1e-12;
+    // Unchecked and checked real paths agree on x / 0.
+    CompiledExpression<double> quotient49(Expression<double>::fromString("x / y"));
+    double signed49[] = {-1.0, 0.0}, zero49[] = {0.0, 0.0}, quotients49[2];
+    const double* quotientColumns49[] = {signed49, zero49};
+    quotient49.evaluateBatch(quotientColumns49, quotients49, 2);
+    complex49Ok = complex49Ok && quotients49[0] == -std::numeric_limits<double>::infinity() && std::isnan(quotients49[1])
+        && Expression<double>::fromString("x / 0").evaluate({{"x", -1.0}}) == quotients49[0];
+
+    BulkEvaluator bulk49(Expression<double>::fromString("ln(x) / y + x"), {"x"}, true);
+    std::istringstream csv49("x,y\n1,2\n0,1\n2,0\n");
+    std::ostringstream result49;
+    DomainReport bulkReport49 = bulk49.evaluateCsv(csv49, result49);
+    std::cerr.rdbuf(saved49);
+    bool bulk49Ok = bulk49.outputs().back() == "status" && bulkReport49.points() == 3 && bulkReport49.flagged() == 2
+        && result49.str().substr(result49.str().size() - 2) == "5\n";
+    if (batch49 && report49Ok && complex49Ok && bulk49Ok && quiet49.str().empty()) std::cout << "Test 49 OK\n";
+    else std::cout << "Test 49 FAIL (batch " << batch49 << ", report " << report49Ok << ", complex " << complex49Ok
+                   << ", bulk " << bulk49Ok << ", quiet " << quiet49.str().empty() << ")\n";
+}
+
 int main() {
     runTests();
+    runCompiledTests();
+    runBatchTests();
+    runDagTests();
+    runGradientTests();
+    runArenaTests();
+    runParserTests();
+    runBindingTests();
+    runNativeTests();
+    runServerTests();
+    runCacheTests();
+    runThreadPoolTests();
+    runSystemTests();
+    runSimplifierTests();
+    runStatsTests();
+    runComplexBatchTests();
+    runIncrementalTests();
+    runSpecializeTests();
+    runSolverTests();
+    runPolynomialTests();
+    runBulkTests();
+    runStaticTests();
+    runDomainTests();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads)
+    : job(nullptr),
+      remaining(0),
+      generation(0),
+      stolen(0),
+      stopping(false) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 1; i < threads; i++) workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    std::lock_guard<std::mutex> call(calling);
+    size_t chunks = (count + grain - 1) / grain;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        failure = nullptr;
+        remaining = chunks;
+        for (size_t c = 0; c < chunks; c++) {
+            Queue& queue = *queues[c * queues.size() / chunks];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.ranges.push_back({c * grain, std::min(count, (c + 1) * grain)});
+        }
+        generation++;
+    }
+    wake.notify_all();
+
+    while (runOne(0)) {
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+    if (failure) std::rethrow_exception(failure);
+}
+
+void ThreadPool::work(size_t self) {
+    size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        while (runOne(self)) {
+        }
+    }
+}
+
+bool ThreadPool::runOne(size_t self) {
+    Range range{0, 0};
+    bool found = false;
+    bool steal = false;
+    for (size_t k = 0; k < queues.size() && !found; k++) {
+        Queue& queue = *queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty()) continue;
+        if (k == 0) {
+            range = queue.ranges.front();
+            queue.ranges.pop_front();
+        } else {
+            range = queue.ranges.back();
+            queue.ranges.pop_back();
+            steal = true;
+        }
+        found = true;
+    }
+    if (!found) return false;
+
+    std::exception_ptr error;
+    try {
+        (*job)(range.begin, range.end);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error && !failure) failure = error;
+    if (steal) stolen++;
+    if (--remaining == 0) done.notify_all();
+    return true;
+}
+
+size_t ThreadPool::size() const {
+    return queues.size();
+}
+
+size_t ThreadPool::steals() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stolen;
+}
\ No newline at end of file
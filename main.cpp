@@ -1,11 +1,72 @@
 #include "Expression.hpp"
+#include "CompiledExpression.hpp"
+#include "NativeExpression.hpp"
+#include "ExpressionServer.hpp"
+#include "ThreadPool.hpp"
+#include "ExpressionSystem.hpp"
+#include "ExpressionSimplifier.hpp"
+#include "ExpressionStats.hpp"
+#include "NewtonSolver.hpp"
+#include "BulkEvaluator.hpp"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <vector>
+#include <memory>
 
-int main(int argc, char* argv[]) {
+static std::complex<double> parseComplex(const std::string& text) {
+    std::string body = text;
+    double imaginary = 0.0;
+    if (!body.empty() && body.back() == 'i') {
+        body.pop_back();
+        size_t split = std::string::npos;
+        for (size_t i = body.size(); i-- > 1;) {
+            if ((body[i] == '+' || body[i] == '-') && body[i - 1] != 'e' && body[i - 1] != 'E') {
+                split = i;
+                break;
+            }
+        }
+        std::string imagText = split == std::string::npos ? body : body.substr(split);
+        body = split == std::string::npos ? "" : body.substr(0, split);
+        if (imagText.empty() || imagText == "+") imaginary = 1.0;
+        else if (imagText == "-") imaginary = -1.0;
+        else {
+            size_t used = 0;
+            imaginary = std::stod(imagText, &used);
+            if (used != imagText.size()) throw std::invalid_argument("Invalid complex value '" + text + "'.");
+        }
+        if (body.empty()) return {0.0, imaginary};
+    }
+    size_t used = 0;
+    double real = std::stod(body, &used);
+    if (used != body.size()) throw std::invalid_argument("Invalid complex value '" + text + "'.");
+    return {real, imaginary};
+}
+
+static std::string formatComplex(std::complex<double> value) {
+    std::ostringstream out;
+    out << value.real() << (std::signbit(value.imag()) ? "-" : "+") << std::abs(value.imag()) << "i";
+    return out.str();
+}
+
+static int run(int argc, char* argv[]) {
     if (argc < 2) {
         std::cerr << "Usage: differentiator --eval \"expression\" var=value ...\n";
         std::cerr << "       differentiator --diff \"expression\" --by variable\n";
+        std::cerr << "       differentiator --simplify \"expression\"\n";
+        std::cerr << "       differentiator --specialize \"expression\" var=value ...\n";
+        std::cerr << "       differentiator --grad \"expression\" var=value ...\n";
+        std::cerr << "       differentiator --batch \"expression\" file [--threads N]\n";
+        std::cerr << "       differentiator --jacobian \"expression\" ... [--by variable ...] [var=value ...]\n";
+        std::cerr << "       differentiator --hessian \"expression\" ... [--by variable ...] [var=value ...]\n";
+        std::cerr << "       differentiator --solve \"expression\" --by variable --starts file [--minimize] [--iterations N] [--tolerance t] [var=value ...]\n";
+        std::cerr << "       differentiator --bulk \"expression\" file [--output file] [--by variable ...] [--threads N] [--status]\n";
+        std::cerr << "       differentiator --pack file.csv file\n";
+        std::cerr << "       differentiator --serve [socket]\n";
+        std::cerr << "       differentiator --codegen \"expression\" [--by variable ...]\n";
+        std::cerr << "       differentiator --complex \"expression\" var=value ... | --batch file\n";
+        std::cerr << "       differentiator --stats <command> ...\n";
         return 1;
     }
 
@@ -15,18 +76,18 @@ int main(int argc, char* argv[]) {
         std::string exprStr = argv[2];
         Expression<double> expr = Expression<double>::fromString(exprStr);
 
-        std::map<std::string, double> values;
+        std::vector<std::string> names;
+        std::vector<double> values;
         for (int i = 3; i < argc; i++) {
             std::string arg = argv[i];
             size_t eqPos = arg.find("=");
             if (eqPos != std::string::npos) {
-                std::string var = arg.substr(0, eqPos);
-                double val = std::stod(arg.substr(eqPos + 1));
-                values[var] = val;
+                names.push_back(arg.substr(0, eqPos));
+                values.push_back(std::stod(arg.substr(eqPos + 1)));
             }
         }
 
-        std::cout << expr.evaluate(values) << "\n";
+        std::cout << expr.bind(names).evaluate(values.data()) << "\n";
     }
     else if (command == "--diff") {
         std::string exprStr = argv[2];
@@ -42,10 +103,367 @@ int main(int argc, char* argv[]) {
         Expression<double> diffExpr = expr.differentiate(var);
         std::cout << diffExpr.toString() << "\n";
     }
+    else if (command == "--grad") {
+        std::string exprStr = argv[2];
+        Expression<double> expr = Expression<double>::fromString(exprStr);
+
+        std::map<std::string, double> values;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eqPos = arg.find("=");
+            if (eqPos != std::string::npos) {
+                values[arg.substr(0, eqPos)] = std::stod(arg.substr(eqPos + 1));
+            }
+        }
+
+        Gradient<double> grad = expr.gradient(values);
+        std::cout << grad.value << "\n";
+        for (const auto& [var, partial] : grad.partials) {
+            std::cout << "d/d" << var << " = " << partial << "\n";
+        }
+    }
+    else if (command == "--batch") {
+        if (argc < 4) {
+            std::cerr << "Error: Missing input file for batch evaluation.\n";
+            return 1;
+        }
+        std::ifstream in(argv[3]);
+        if (!in) {
+            std::cerr << "Error: Cannot open " << argv[3] << "\n";
+            return 1;
+        }
+
+        size_t threads = 1;
+        if (argc >= 6 && std::string(argv[4]) == "--threads") threads = std::stoul(argv[5]);
+
+        std::string header;
+        std::getline(in, header);
+        std::istringstream headerStream(header);
+        std::vector<std::string> names;
+        for (std::string name; headerStream >> name;) names.push_back(name);
+        if (names.empty()) {
+            std::cerr << "Error: Missing variable names in the first line of " << argv[3] << "\n";
+            return 1;
+        }
+
+        std::vector<std::vector<double>> columns(names.size());
+        size_t count = 0;
+        for (double value; in >> value; count++) {
+            columns[count % names.size()].push_back(value);
+        }
+        size_t rows = count / names.size();
+
+        CompiledExpression<double> compiled(Expression<double>::fromString(argv[2]));
+        std::vector<const double*> inputs;
+        for (const std::string& var : compiled.variables()) {
+            size_t i = std::find(names.begin(), names.end(), var) - names.begin();
+            if (i == names.size()) {
+                std::cerr << "Error: " << argv[3] << " has no column '" << var << "'\n";
+                return 1;
+            }
+            inputs.push_back(columns[i].data());
+        }
+
+        std::vector<double> results(rows);
+        std::vector<unsigned char> status(rows);
+        if (threads == 1) {
+            compiled.evaluateBatch(inputs.data(), results.data(), rows, status.data());
+        } else {
+            ThreadPool pool(threads);
+            compiled.evaluateBatch(inputs.data(), results.data(), rows, status.data(), pool);
+        }
+        for (double r : results) std::cout << r << "\n";
+        DomainReport report;
+        report.record(status.data(), rows);
+        if (!report.clean()) report.print(std::cerr);
+    }
+    else if (command == "--simplify") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing expression to simplify.\n";
+            return 1;
+        }
+        ExpressionSimplifier<double> simplifier;
+        Expression<double> simplified = simplifier.simplify(Expression<double>::fromString(argv[2]));
+        std::cout << simplified.toString() << "\n";
+        std::cout << "nodes: " << simplifier.stats().before << " -> " << simplifier.stats().after << "\n";
+    }
+    else if (command == "--specialize") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing expression to specialize.\n";
+            return 1;
+        }
+        std::map<std::string, double> values;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eqPos = arg.find("=");
+            if (eqPos != std::string::npos) {
+                values[arg.substr(0, eqPos)] = std::stod(arg.substr(eqPos + 1));
+            }
+        }
+        std::cout << Expression<double>::fromString(argv[2]).specialize(values).toString() << "\n";
+    }
+    else if (command == "--jacobian" || command == "--hessian") {
+        std::vector<Expression<double>> exprs;
+        std::vector<std::string> vars;
+        std::map<std::string, double> point;
+        bool byList = false;
+        for (int i = 2; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eqPos = arg.find("=");
+            if (arg == "--by") byList = true;
+            else if (eqPos != std::string::npos) point[arg.substr(0, eqPos)] = std::stod(arg.substr(eqPos + 1));
+            else if (byList) vars.push_back(arg);
+            else exprs.push_back(Expression<double>::fromString(arg));
+        }
+        if (exprs.empty()) {
+            std::cerr << "Error: Missing expressions.\n";
+            return 1;
+        }
+        std::vector<std::string> used;
+        for (const Expression<double>& expr : exprs) {
+            std::vector<std::string> names = expr.variables();
+            used.insert(used.end(), names.begin(), names.end());
+        }
+        std::sort(used.begin(), used.end());
+        used.erase(std::unique(used.begin(), used.end()), used.end());
+        if (vars.empty()) vars = used;
+        // --by only picks what to differentiate by; every variable needs a value.
+        for (const std::string& var : used) {
+            if (!point.empty() && !point.count(var)) {
+                std::cerr << "Error: Missing value for " << var << "\n";
+                return 1;
+            }
+        }
+
+        ExpressionSystem<double> system(exprs, vars);
+        auto print = [&](const std::string& prefix, const std::vector<ExpressionSystem<double>::Entry>& entries, bool square) {
+            std::vector<double> results;
+            if (!point.empty()) results = system.evaluate(entries, point);
+            for (size_t e = 0; e < entries.size(); e++) {
+                std::cout << prefix << "[" << (square ? vars[entries[e].row] : std::to_string(entries[e].row)) << "][" << vars[entries[e].col] << "] = ";
+                if (point.empty()) std::cout << system.expression(entries[e]).toString() << "\n";
+                else std::cout << results[e] << "\n";
+            }
+        };
+        if (command == "--jacobian") {
+            print("J", system.jacobian(), false);
+        } else {
+            for (size_t i = 0; i < exprs.size(); i++) print("H" + std::to_string(i), system.hessian(i), true);
+        }
+    }
+    else if (command == "--complex") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing expression for complex evaluation.\n";
+            return 1;
+        }
+        typedef std::complex<double> Complex;
+        Expression<Complex> expr = Expression<Complex>::fromString(argv[2]);
+        if (argc >= 5 && std::string(argv[3]) == "--batch") {
+            std::ifstream in(argv[4]);
+            if (!in) {
+                std::cerr << "Error: Cannot open " << argv[4] << "\n";
+                return 1;
+            }
+            std::string header;
+            std::getline(in, header);
+            std::istringstream headerStream(header);
+            std::vector<std::string> names;
+            for (std::string name; headerStream >> name;) names.push_back(name);
+            if (names.empty()) {
+                std::cerr << "Error: Missing variable names in the first line of " << argv[4] << "\n";
+                return 1;
+            }
+
+            std::vector<std::vector<double>> real(names.size()), imag(names.size());
+            size_t count = 0;
+            for (std::string token; in >> token; count++) {
+                Complex value = parseComplex(token);
+                real[count % names.size()].push_back(value.real());
+                imag[count % names.size()].push_back(value.imag());
+            }
+            size_t rows = count / names.size();
+
+            CompiledExpression<Complex> compiled = expr.bind(names);
+            std::vector<const double*> realColumns, imagColumns;
+            for (size_t i = 0; i < names.size(); i++) {
+                realColumns.push_back(real[i].data());
+                imagColumns.push_back(imag[i].data());
+            }
+            std::vector<double> outReal(rows), outImag(rows);
+            std::vector<unsigned char> status(rows);
+            compiled.evaluateBatch(realColumns.data(), imagColumns.data(), outReal.data(), outImag.data(), rows, status.data());
+            for (size_t i = 0; i < rows; i++) std::cout << formatComplex({outReal[i], outImag[i]}) << "\n";
+            DomainReport report;
+            report.record(status.data(), rows);
+            if (!report.clean()) report.print(std::cerr);
+        } else {
+            std::vector<std::string> names;
+            std::vector<Complex> values;
+            for (int i = 3; i < argc; i++) {
+                std::string arg = argv[i];
+                size_t eqPos = arg.find("=");
+                if (eqPos != std::string::npos) {
+                    names.push_back(arg.substr(0, eqPos));
+                    values.push_back(parseComplex(arg.substr(eqPos + 1)));
+                }
+            }
+            std::cout << formatComplex(expr.bind(names).evaluate(values.data())) << "\n";
+        }
+    }
+    else if (command == "--solve") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing expression to solve.\n";
+            return 1;
+        }
+        std::string var;
+        std::string startsPath;
+        bool minimize = false;
+        size_t iterations = 50;
+        double tolerance = 1e-12;
+        std::map<std::string, double> fixed;
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eqPos = arg.find("=");
+            if (arg == "--minimize") minimize = true;
+            else if (arg == "--by" && i + 1 < argc) var = argv[++i];
+            else if (arg == "--starts" && i + 1 < argc) startsPath = argv[++i];
+            else if (arg == "--iterations" && i + 1 < argc) iterations = std::stoul(argv[++i]);
+            else if (arg == "--tolerance" && i + 1 < argc) tolerance = std::stod(argv[++i]);
+            else if (eqPos != std::string::npos) fixed[arg.substr(0, eqPos)] = std::stod(arg.substr(eqPos + 1));
+            else {
+                std::cerr << "Error: Unexpected argument " << arg << "\n";
+                return 1;
+            }
+        }
+        if (var.empty() || startsPath.empty()) {
+            std::cerr << "Error: --solve needs --by variable and --starts file.\n";
+            return 1;
+        }
+        std::ifstream in(startsPath);
+        if (!in) {
+            std::cerr << "Error: Cannot open " << startsPath << "\n";
+            return 1;
+        }
+        std::vector<double> starts;
+        size_t lineNumber = 0;
+        for (std::string line; std::getline(in, line);) {
+            lineNumber++;
+            std::istringstream fields(line);
+            for (double value; fields >> value;) starts.push_back(value);
+            if (!fields.eof()) {
+                std::cerr << "Error: Invalid number on line " << lineNumber << " of " << startsPath << ": " << line << "\n";
+                return 1;
+            }
+        }
+
+        Expression<double> expr = Expression<double>::fromString(argv[2]).specialize(fixed);
+        NewtonSolver solver(expr, var, minimize);
+        for (const NewtonSolver::Result& r : solver.solve(starts, iterations, tolerance)) {
+            std::cout << r.start << " " << r.x << " " << r.iterations << " " << r.residual << " "
+                      << (r.converged ? "converged" : "failed") << "\n";
+        }
+    }
+    else if (command == "--bulk") {
+        if (argc < 4) {
+            std::cerr << "Error: Missing input file for bulk evaluation.\n";
+            return 1;
+        }
+        std::string inputPath = argv[3];
+        std::string outputPath;
+        std::vector<std::string> derivatives;
+        size_t threads = 1;
+        bool statusColumn = false;
+        for (int i = 4; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--status") statusColumn = true;
+            else if (arg == "--output" && i + 1 < argc) outputPath = argv[++i];
+            else if (arg == "--by" && i + 1 < argc) derivatives.push_back(argv[++i]);
+            else if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+            else {
+                std::cerr << "Error: Unexpected argument " << arg << "\n";
+                return 1;
+            }
+        }
+
+        BulkEvaluator bulk(Expression<double>::fromString(argv[2]), derivatives, statusColumn);
+        DomainReport report;
+        if (ColumnFile::recognize(inputPath)) {
+            if (outputPath.empty()) {
+                std::cerr << "Error: A column file input needs --output file.\n";
+                return 1;
+            }
+            std::unique_ptr<ThreadPool> pool;
+            if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
+            report = bulk.evaluate(ColumnFile(inputPath), outputPath, pool.get());
+        } else {
+            std::ifstream in(inputPath);
+            if (!in) {
+                std::cerr << "Error: Cannot open " << inputPath << "\n";
+                return 1;
+            }
+            if (outputPath.empty()) {
+                report = bulk.evaluateCsv(in, std::cout);
+            } else {
+                std::ofstream out(outputPath);
+                if (!out) {
+                    std::cerr << "Error: Cannot create " << outputPath << "\n";
+                    return 1;
+                }
+                report = bulk.evaluateCsv(in, out);
+            }
+        }
+        if (!report.clean()) report.print(std::cerr);
+    }
+    else if (command == "--pack") {
+        if (argc < 4) {
+            std::cerr << "Error: --pack needs a CSV input and an output file.\n";
+            return 1;
+        }
+        std::cout << BulkEvaluator::pack(argv[2], argv[3]) << " rows\n";
+    }
+    else if (command == "--serve") {
+        ExpressionServer server;
+        if (argc >= 3) server.listen(argv[2]);
+        else server.serve(0, 1);
+    }
+    else if (command == "--codegen") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing expression for code generation.\n";
+            return 1;
+        }
+        Expression<double> expr = Expression<double>::fromString(argv[2]);
+        std::vector<std::string> derivatives;
+        for (int i = 3; i < argc; i++) {
+            if (std::string(argv[i]) != "--by" || i + 1 == argc) {
+                std::cerr << "Error: Expected --by variable, got " << argv[i] << "\n";
+                return 1;
+            }
+            derivatives.push_back(argv[++i]);
+        }
+        std::cout << NativeExpression::source(expr, derivatives, expr.variables());
+    }
     else {
         std::cerr << "Unknown command: " << command << "\n";
         return 1;
     }
 
     return 0;
+}
+
+int main(int argc, char* argv[]) {
+    bool stats = argc > 1 && std::string(argv[1]) == "--stats";
+    if (stats) {
+        ExpressionStats::enable();
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+    }
+    int status = 1;
+    try {
+        status = run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+    }
+    if (stats) ExpressionStats::report(std::cerr);
+    return status;
 }
\ No newline at end of file